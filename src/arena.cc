@@ -0,0 +1,95 @@
+#include "arena.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+Arena::Arena(size_t bytes)
+    : map_base_(nullptr),
+      map_size_(0),
+      base_(nullptr),
+      capacity_((bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE),
+      used_(0),
+      explicit_huge_pages_(false),
+      transparent_huge_pages_(false) {
+    if (capacity_ == 0) return;
+
+    void *p;
+#ifdef MAP_HUGETLB
+    p = mmap(nullptr, capacity_, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        base_ = static_cast<char *>(p);
+        explicit_huge_pages_ = true;
+        return;
+    }
+#endif
+
+    // 多映射一个大页的大小，使起始地址按2MiB对齐
+    const size_t mapped = capacity_ + HUGE_PAGE_SIZE;
+    p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        cerr << "can't map " << capacity_ << " bytes for the arena" << endl;
+        exit(1);
+    }
+    char *raw = static_cast<char *>(p);
+    char *aligned = reinterpret_cast<char *>(
+        (reinterpret_cast<uintptr_t>(raw) + HUGE_PAGE_SIZE - 1) &
+        ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+    if (aligned > raw) munmap(raw, aligned - raw);
+    munmap(aligned + capacity_, raw + mapped - (aligned + capacity_));
+    base_ = aligned;
+#ifdef MADV_HUGEPAGE
+    transparent_huge_pages_ = madvise(base_, capacity_, MADV_HUGEPAGE) == 0;
+#endif
+}
+
+Arena::Arena(const string &file_name, size_t offset)
+    : map_base_(nullptr),
+      map_size_(0),
+      base_(nullptr),
+      capacity_(0),
+      used_(0),
+      explicit_huge_pages_(false),
+      transparent_huge_pages_(false) {
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < offset) {
+        cerr << "can't open " << file_name << endl;
+        exit(1);
+    }
+    map_size_ = st.st_size;
+    void *p = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                   0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        cerr << "can't map " << file_name << endl;
+        exit(1);
+    }
+    map_base_ = static_cast<char *>(p);
+    base_ = map_base_ + offset;
+    capacity_ = map_size_ - offset;
+}
+
+Arena::~Arena() {
+    if (map_base_) {
+        munmap(map_base_, map_size_);
+    } else if (base_) {
+        munmap(base_, capacity_);
+    }
+}
+
+void *Arena::allocate(size_t bytes, size_t align) {
+    const size_t start = (used_ + align - 1) & ~(align - 1);
+    if (start + bytes > capacity_) return nullptr;
+    used_ = start + bytes;
+    return base_ + start;
+}
@@ -0,0 +1,160 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * A memory region sized once after parsing, from which the per-instance
+ * arrays of ZddWithLinks are carved by bump allocation.
+ * The region is mapped with explicit 2 MiB pages (MAP_HUGETLB) when the
+ * system has them reserved, and otherwise with normal pages advised by
+ * madvise(MADV_HUGEPAGE) so that transparent huge pages can back it.
+ * An arena can also be a private (copy-on-write) mapping of a snapshot file.
+ * Then allocations return the bytes already stored in the file, and
+ * ArenaAllocator leaves them uninitialized instead of zeroing them.
+ * Memory is released only when the arena is destroyed.
+ * 解析后一次性确定大小的内存区域，ZddWithLinks的各数组从中顺序分配。
+ * 优先使用显式的2MiB大页，否则使用普通页并通过madvise(MADV_HUGEPAGE)建议使用透明大页。
+ * 也可以是快照文件的私有（写时复制）映射，此时分配得到的内存即为文件中保存的数据。
+ */
+class Arena {
+   public:
+    static constexpr size_t HUGE_PAGE_SIZE = 2UL << 20;
+
+    /**
+     * @brief 映射至少 bytes 字节的内存区域。
+     * @param bytes 需要的字节数。
+     */
+    explicit Arena(size_t bytes);
+
+    /**
+     * @brief 以MAP_PRIVATE映射整个文件，文件中 offset 之后的部分作为区域。
+     * @param file_name 文件名。
+     * @param offset 区域在文件中的起始位置（页对齐）。
+     */
+    Arena(const std::string &file_name, size_t offset);
+    ~Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * @brief 从区域中分配内存。
+     * @param bytes 字节数。
+     * @param align 对齐字节数（2的幂）。
+     * @return 分配的地址。剩余空间不足时返回 nullptr。
+     */
+    void *allocate(size_t bytes, size_t align);
+
+    /**
+     * @brief 判断地址是否在该区域内。
+     */
+    bool owns(const void *p) const {
+        return base_ != nullptr && static_cast<const char *>(p) >= base_ &&
+               static_cast<const char *>(p) < base_ + capacity_;
+    }
+
+    size_t capacity() const { return capacity_; }
+    // 是否为文件的映射
+    bool file_backed() const { return map_base_ != nullptr; }
+    size_t used() const { return used_; }
+    // 是否使用了显式大页（MAP_HUGETLB）
+    bool explicit_huge_pages() const { return explicit_huge_pages_; }
+    // 是否成功建议使用透明大页（MADV_HUGEPAGE）
+    bool transparent_huge_pages() const { return transparent_huge_pages_; }
+
+   private:
+    char *map_base_;  // 文件映射的起始地址，非文件映射时为 nullptr
+    size_t map_size_;
+    char *base_;
+    size_t capacity_;
+    size_t used_;
+    bool explicit_huge_pages_;
+    bool transparent_huge_pages_;
+};
+
+/**
+ * STL allocator taking memory from an Arena.
+ * Falls back to the heap when there is no arena or the arena is full, so a
+ * vector that outgrows its planned size still works. Copies of a container
+ * use the heap (select_on_container_copy_construction), because they may
+ * outlive the arena.
+ * 从Arena分配内存的STL分配器。没有Arena或空间不足时使用堆。
+ */
+template <typename T>
+class ArenaAllocator {
+   public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator(Arena *arena = nullptr) noexcept : arena_(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &o) noexcept : arena_(o.arena()) {}
+
+    T *allocate(size_t n) {
+        if (arena_) {
+            void *p = arena_->allocate(n * sizeof(T), alignof(T) < 64 ? 64
+                                                                      : alignof(T));
+            if (p) return static_cast<T *>(p);
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    /**
+     * @brief 不带参数的构造。文件映射中的元素保持文件中的值，其余元素进行值初始化。
+     */
+    template <typename U>
+    void construct(U *p) {
+        if (arena_ && arena_->file_backed() && arena_->owns(p)) {
+            ::new (static_cast<void *>(p)) U;
+        } else {
+            ::new (static_cast<void *>(p)) U();
+        }
+    }
+
+    template <typename U, typename... Args>
+    void construct(U *p, Args &&...args) {
+        ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    void deallocate(T *p, size_t) noexcept {
+        if (arena_ && arena_->owns(p)) return;
+        ::operator delete(p);
+    }
+
+    ArenaAllocator select_on_container_copy_construction() const {
+        return ArenaAllocator();
+    }
+
+    Arena *arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &o) const noexcept {
+        return arena_ == o.arena();
+    }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &o) const noexcept {
+        return arena_ != o.arena();
+    }
+
+   private:
+    Arena *arena_;
+};
+
+template <typename T>
+using arena_vector = std::vector<T, ArenaAllocator<T>>;
+
+/**
+ * @brief 计算n个T加上对齐余量在Arena中占用的字节数，用于确定Arena的大小。
+ */
+template <typename T>
+constexpr size_t arena_bytes(size_t n) {
+    return n * sizeof(T) + 64;
+}
+
+#endif  // ARENA_H_
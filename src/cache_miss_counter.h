@@ -0,0 +1,53 @@
+#ifndef CACHE_MISS_COUNTER_H_
+#define CACHE_MISS_COUNTER_H_
+
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+
+/**
+ * hardware cache miss counter of the calling thread using perf_event_open.
+ * 使用perf_event_open统计当前线程的硬件缓存未命中数，不可用时 available() 返回 false。
+ */
+class CacheMissCounter {
+   public:
+    CacheMissCounter() {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~CacheMissCounter() {
+        if (fd_ >= 0) close(fd_);
+    }
+
+    bool available() const { return fd_ >= 0; }
+
+    void start() {
+        if (fd_ < 0) return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    uint64_t stop() {
+        uint64_t count = 0;
+        if (fd_ < 0) return count;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &count, sizeof(count)) != sizeof(count)) count = 0;
+        return count;
+    }
+
+   private:
+    int fd_;
+};
+
+#endif  // CACHE_MISS_COUNTER_H_
@@ -0,0 +1,58 @@
+#ifndef COMPONENT_CACHE_H_
+#define COMPONENT_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/**
+ * cache of the solution counts of components found in the search.
+ * A component is keyed by the serialized reduced ZDD of its options (with its
+ * columns renumbered), so equal residual problems reached along different
+ * branches are solved once. When the keys exceed the byte budget the cache is
+ * cleared and refilled. Counts are 128 bits, as the products of components.
+ * 搜索中找到的连通分量的解数缓存。键为分量的选项的约简ZDD（列重新编号）的序列化，
+ * 因此不同分支上相同的残余问题只求解一次。键的字节数超过上限时清空缓存。
+ */
+class ComponentCache {
+   public:
+    explicit ComponentCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+    /**
+     * @brief 查找分量的解数。
+     * @return 找到时返回 true。
+     */
+    bool lookup(const std::string &key, unsigned __int128 &count) {
+        num_lookups_++;
+        auto it = counts_.find(key);
+        if (it == counts_.end()) return false;
+        num_hits_++;
+        count = it->second;
+        return true;
+    }
+
+    /**
+     * @brief 记录分量的解数。
+     */
+    void insert(const std::string &key, unsigned __int128 count) {
+        // 每个条目另计哈希表节点的开销
+        const size_t bytes = key.size() + 64;
+        if (bytes_ + bytes > max_bytes_) {
+            counts_.clear();
+            bytes_ = 0;
+        }
+        if (counts_.emplace(key, count).second) bytes_ += bytes;
+    }
+
+    uint64_t num_lookups() const { return num_lookups_; }
+    uint64_t num_hits() const { return num_hits_; }
+
+   private:
+    std::unordered_map<std::string, unsigned __int128> counts_;
+    size_t bytes_ = 0;
+    const size_t max_bytes_;
+    uint64_t num_lookups_ = 0;
+    uint64_t num_hits_ = 0;
+};
+
+#endif  // COMPONENT_CACHE_H_
@@ -2,18 +2,45 @@
 
 #include "dancing_on_zdd.h"
 
+#include <cstring>
+#include <numeric>
 #include <unordered_map>
 #include <unordered_set>
 
-#include "dp_manager.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-uint64_t ZddWithLinks::num_inactive_updates = 0UL;
-uint64_t ZddWithLinks::num_search_tree_nodes = 0UL;
-uint64_t ZddWithLinks::num_updates = 0UL;
-uint64_t ZddWithLinks::num_head_updates = 0UL;
-uint64_t ZddWithLinks::num_solutions = 0UL;
-uint64_t ZddWithLinks::num_hides = 0UL;
-uint64_t ZddWithLinks::num_failure_backtracks = 0UL;
+#include "dp_manager.h"
+#include "raw_zdd.h"
+#include "snapshot.h"
+#include "unique_table.h"
+
+// 默认的并行建立舞动链接的最小节点数
+constexpr size_t DEFAULT_PARALLEL_SETUP_THRESHOLD = 1 << 16;
+// 建立舞动链接时在层内并行的最小节点数，更小的层串行处理
+constexpr size_t PARALLEL_SETUP_MIN_LEVEL = 4096;
+
+template <typename Traits>
+uint64_t ZddWithLinks<Traits>::num_inactive_updates = 0UL;
+template <typename Traits>
+uint64_t ZddWithLinks<Traits>::num_search_tree_nodes = 0UL;
+template <typename Traits>
+uint64_t ZddWithLinks<Traits>::num_updates = 0UL;
+template <typename Traits>
+uint64_t ZddWithLinks<Traits>::num_head_updates = 0UL;
+template <typename Traits>
+count128_t ZddWithLinks<Traits>::num_solutions = 0;
+template <typename Traits>
+uint64_t ZddWithLinks<Traits>::num_hides = 0UL;
+template <typename Traits>
+uint64_t ZddWithLinks<Traits>::num_failure_backtracks = 0UL;
+template <typename Traits>
+uint64_t ZddWithLinks<Traits>::num_decompositions = 0UL;
+template <typename Traits>
+uint64_t ZddWithLinks<Traits>::num_recompressions = 0UL;
+template <typename Traits>
+uint64_t ZddWithLinks<Traits>::num_recompress_skips = 0UL;
 
 /**
  * ZddWithLinks 类的构造函数
@@ -21,26 +48,37 @@ uint64_t ZddWithLinks::num_failure_backtracks = 0UL;
  * @param sanity_check 是否进行一致性检查。
  * 初始化 ZDD 结构，设置节点和头部单元，并准备动态规划管理器和隐藏节点栈。
  */
-ZddWithLinks::ZddWithLinks(int num_var, bool sanity_check)
+template <typename Traits>
+ZddWithLinks<Traits>::ZddWithLinks(int num_var, bool sanity_check)
     : num_var_(num_var),
+      arena_(nullptr),
       table_(),
       dp_mgr_(nullptr),
       hidden_node_stack_(make_unique<HiddenNodeStack>(HiddenNodeStack())),
       sanity_check_(sanity_check),
-      depth_choice_buf_(MAX_DEPTH, std::vector<uint16_t>()),
-      depth_upper_choice_buf_(MAX_DEPTH, std::vector<uint16_t>()),
-      depth_lower_choice_buf_(MAX_DEPTH, std::vector<uint16_t>()),
-      depth_lower_trace_buf_(MAX_DEPTH, std::vector<uint32_t>()),
+      recompress_depth_(-1),
+      recompress_ratio_(1.0),
+      decompose_interval_(-1),
+      skip_decompose_depth_(-1),
+      component_cache_(nullptr),
+      parallel_level_threshold_(0),
+      parallel_setup_threshold_(DEFAULT_PARALLEL_SETUP_THRESHOLD),
+      depth_choice_buf_(MAX_DEPTH, std::vector<var_t>()),
+      depth_upper_choice_buf_(MAX_DEPTH, std::vector<var_t>()),
+      depth_lower_choice_buf_(MAX_DEPTH, std::vector<var_t>()),
+      depth_lower_trace_buf_(MAX_DEPTH, std::vector<trace_t>()),
       depth_lower_change_pts_buf_(MAX_DEPTH, std::vector<size_t>()),
-      depth_upper_trace_buf_(MAX_DEPTH, std::vector<uint32_t>()),
+      depth_upper_trace_buf_(MAX_DEPTH, std::vector<trace_t>()),
       depth_upper_change_pts_buf_(MAX_DEPTH, std::vector<size_t>()),
-      depth_upper_change_node_ids_buf_(MAX_DEPTH, std::vector<int32_t>()) {
+      depth_upper_change_node_ids_buf_(MAX_DEPTH, std::vector<index_t>()) {
     header_.emplace_back(num_var_, 1, -1, -1, 0,
                          0);  // the head of header cells
     for (int i = 0; i < num_var_; i++) {
         header_.emplace_back(i, i + 2, -1, -1, i + 1, 0);
     }
     header_[num_var].right = 0;
+    // the head of secondary columns, which are moved by set_secondary_columns
+    header_.emplace_back(num_var_ + 1, num_var_ + 1, -1, -1, 0, 0);
 }
 
 /**
@@ -48,25 +86,43 @@ ZddWithLinks::ZddWithLinks(int num_var, bool sanity_check)
  * @param obj 要复制的 ZddWithLinks 对象。
  * 复制 ZDD 结构的节点和头部单元，但不复制动态规划管理器和隐藏节点栈。
  */
-ZddWithLinks::ZddWithLinks(const ZddWithLinks &obj)
+template <typename Traits>
+ZddWithLinks<Traits>::ZddWithLinks(const ZddWithLinks &obj)
     : num_var_(obj.num_var_),
+      arena_(nullptr),
       table_(obj.table_),
       header_(obj.header_),
       dp_mgr_(nullptr),
       hidden_node_stack_(nullptr),
       sanity_check_(false),
-      depth_choice_buf_(MAX_DEPTH, std::vector<uint16_t>()),
-      depth_upper_choice_buf_(MAX_DEPTH, std::vector<uint16_t>()),
-      depth_lower_choice_buf_(MAX_DEPTH, std::vector<uint16_t>()) {}
-
-bool ZddWithLinks::operator==(const ZddWithLinks &obj) const {
+      recompress_depth_(-1),
+      recompress_ratio_(obj.recompress_ratio_),
+      decompose_interval_(obj.decompose_interval_),
+      skip_decompose_depth_(obj.skip_decompose_depth_),
+      component_cache_(obj.component_cache_),
+      parallel_level_threshold_(obj.parallel_level_threshold_),
+      parallel_setup_threshold_(obj.parallel_setup_threshold_),
+      side_cells_(obj.side_cells_),
+      side_row_begin_(obj.side_row_begin_),
+      side_count_(obj.side_count_),
+      min_cover_(obj.min_cover_),
+      max_cover_(obj.max_cover_),
+      num_covered_(obj.num_covered_),
+      min_option_depth_(obj.min_option_depth_),
+      depth_option_buf_(obj.depth_option_buf_),
+      depth_choice_buf_(MAX_DEPTH, std::vector<var_t>()),
+      depth_upper_choice_buf_(MAX_DEPTH, std::vector<var_t>()),
+      depth_lower_choice_buf_(MAX_DEPTH, std::vector<var_t>()) {}
+
+template <typename Traits>
+bool ZddWithLinks<Traits>::operator==(const ZddWithLinks &obj) const {
     // intended to be used for debugging.
     if (num_var_ != obj.num_var_) return false;
 
     if (table_.size() != obj.table_.size()) return false;
     bool equals = true;
     for (size_t i = 0; i < table_.size(); i++) {
-        if (table_[i] != obj.table_[i]) {
+        if (table_.node_at(i) != obj.table_.node_at(i)) {
             fprintf(stderr, "node %lu differs\n", i);
             equals = false;
         }
@@ -78,15 +134,47 @@ bool ZddWithLinks::operator==(const ZddWithLinks &obj) const {
             equals = false;
         }
     }
+    if (side_cells_.size() != obj.side_cells_.size()) return false;
+    for (size_t i = 0; i < side_cells_.size(); i++) {
+        const SideCell &a = side_cells_[i], &b = obj.side_cells_[i];
+        if (a.col != b.col || a.up != b.up || a.down != b.down ||
+            a.row != b.row) {
+            fprintf(stderr, "side cell %lu differs\n", i);
+            equals = false;
+        }
+    }
     return equals;
 }
 
-void ZddWithLinks::search(vector<vector<uint16_t>> &solution, const int depth) {
+template <typename Traits>
+void ZddWithLinks<Traits>::search(vector<vector<var_t>> &solution, const int depth) {
+    if (!max_cover_.empty()) {
+        search_with_bounds(solution, depth);
+        return;
+    }
+
+    // 到达重新压缩深度时，存活的节点足够少则在紧凑的残余子ZDD上继续搜索。
+    // 隐藏的节点都在隐藏节点栈中，因此存活节点数不需要遍历即可得到
+    if (depth == recompress_depth_ && header_[0].right != 0) {
+        const size_t num_live =
+            table_.size() - hidden_node_stack_->num_hidden();
+        if (num_live > recompress_ratio_ * table_.size()) {
+            num_recompress_skips++;
+        } else {
+            auto residual = extract_residual();
+            if (residual) {
+                num_recompressions++;
+                residual->search(solution, depth);
+                return;
+            }
+        }
+    }
+
     // 增加搜索树节点的计数器
     num_search_tree_nodes++;
     
-    // 如果头部的右链接为0，表示所有列都被覆盖，找到一个解决方案
-    if (header_[0].right == 0)  // all columns are covered
+    // 如果头部的右链接为0，表示所有主列都被覆盖，找到一个解决方案
+    if (header_[0].right == 0)  // all primary columns are covered
     {
         // 增加解决方案计数器
         num_solutions += 1;
@@ -96,11 +184,11 @@ void ZddWithLinks::search(vector<vector<uint16_t>> &solution, const int depth) {
 
     // choose the column with minimum count
     // 初始化最小选项数为最大值，最小选项列为-1，剩余列计数为0
-    count_t min_count = UINT32_MAX;
+    count_t min_count = ~count_t(0);
     int min_count_column = -1;
     int remain_cols = 0;
 
-    // 遍历所有未覆盖的列，寻找具有最小选项数的列
+    // 遍历所有未覆盖的主列，寻找具有最小选项数的列
     for (int head_pos = header_[0].right; head_pos != 0;
          head_pos = header_[head_pos].right) {
         const Header &header = header_[head_pos];
@@ -119,25 +207,37 @@ void ZddWithLinks::search(vector<vector<uint16_t>> &solution, const int depth) {
             min_count = header.count;
         }
     }
+    if (!side_cells_.empty()) {
+        min_count_column = choose_column_with_side_rows();
+    }
+
+    // 残余问题分为多个连通分量时，分别求解并相乘
+    if (decompose_interval_ >= 0 && depth != skip_decompose_depth_ &&
+        remain_cols > 1 &&
+        (depth == 0 ||
+         (decompose_interval_ > 0 && depth % decompose_interval_ == 0)) &&
+        count_by_components(solution, depth)) {
+        return;
+    }
 
     // 清空当前深度的选择缓冲区，并将最小选项列加入其中
     depth_choice_buf_[depth].clear();
-    depth_choice_buf_[depth].push_back((uint16_t)min_count_column);
+    depth_choice_buf_[depth].push_back((var_t)min_count_column);
     
     // 批量覆盖选择的列
     batch_cover(std::cbegin(depth_choice_buf_[depth]),
                 std::cend(depth_choice_buf_[depth]));
-    int node_id = header_[min_count_column].down;
+    index_t node_id = header_[min_count_column].down;
 
     int lower_change_idx = -1;
     
     // 遍历选择的列的所有节点
     while (node_id >= 0) {
         // choose an option and cover columns
-        const Node &node = table_[node_id];
+        const auto node = table_[node_id];
         
         // 遍历节点的所有上方向选项
-        for (auto up_id = 0; up_id < node.count_upper; ++up_id) {
+        for (count_t up_id = 0; up_id < node.count_upper; ++up_id) {
             // 计算上方向的选择路径
             compute_upper_choice(node_id, up_id,
                                  depth_upper_choice_buf_[depth]);
@@ -170,6 +270,22 @@ void ZddWithLinks::search(vector<vector<uint16_t>> &solution, const int depth) {
         // 移动到下一个节点
         node_id = node.down;
     }
+    // ZDD之外的行：覆盖该行的其余列
+    if (!side_cells_.empty()) {
+        vector<var_t> &row_cols = depth_upper_choice_buf_[depth];
+        for (index_t cell = side_cells_[min_count_column].down;
+             cell != min_count_column; cell = side_cells_[cell].down) {
+            const index_t row = side_cells_[cell].row;
+            row_cols.clear();
+            for (index_t c = side_row_begin_[row]; c < side_row_begin_[row + 1];
+                 c++) {
+                if (c != cell) row_cols.push_back(side_cells_[c].col);
+            }
+            batch_cover(row_cols.begin(), row_cols.end());
+            search(solution, depth + 1);
+            batch_uncover(row_cols.begin(), row_cols.end());
+        }
+    }
     // 取消覆盖当前深度的选择列
     batch_uncover(std::cbegin(depth_choice_buf_[depth]),
                   std::cend(depth_choice_buf_[depth]));
@@ -182,52 +298,1016 @@ void ZddWithLinks::search(vector<vector<uint16_t>> &solution, const int depth) {
     return;
 }
 
-void ZddWithLinks::load_zdd_from_file(const string &file_name) {
-    ifstream ifs(file_name);
+template <typename Traits>
+count128_t ZddWithLinks<Traits>::count_with_assumptions(
+    const Assumptions &assumptions, vector<vector<var_t>> &solution) {
+    vector<var_t> columns, covered;
+    vector<vector<var_t>> excluded;
+    if (!apply_assumptions(assumptions, columns, covered, excluded)) return 0;
+
+    num_solutions = 0;
+    // 删除的选项在开始时一次性去掉：在不含它们的残余子ZDD上搜索，
+    // 因此重新压缩、分量分解和ZDD之外的行都照常工作
+    unique_ptr<ZddWithLinks> residual;
+    if (!excluded.empty()) {
+        residual = extract_residual(excluded);
+        if (residual) {
+            residual->set_recompress_depth(recompress_depth_,
+                                           recompress_ratio_);
+        }
+    }
+    if (residual) {
+        residual->search(solution, 0);
+    } else if (excluded.empty()) {
+        search(solution, 0);
+    } else {
+        num_solutions = live_primary_satisfied() ? 1 : 0;
+    }
+    restore_assumptions(columns, covered);
+    return num_solutions;
+}
+
+template <typename Traits>
+bool ZddWithLinks<Traits>::write_residual_with_assumptions(
+    const Assumptions &assumptions, const string &file_name,
+    count128_t &count) {
+    vector<var_t> columns, covered;
+    vector<vector<var_t>> excluded;
+    count = 0;
+    if (!apply_assumptions(assumptions, columns, covered, excluded)) {
+        return false;
+    }
+    // 不写入时残余问题没有选项或有无法覆盖的主列
+    const bool written = write_zdd_to_file(file_name, excluded);
+    if (!written) count = live_primary_satisfied() ? 1 : 0;
+    restore_assumptions(columns, covered);
+    return written;
+}
 
-    if (!ifs) {
-        cerr << "can't open " << file_name << endl;
-        exit(1);
+template <typename Traits>
+bool ZddWithLinks<Traits>::apply_assumptions(
+    const Assumptions &assumptions, vector<var_t> &columns,
+    vector<var_t> &covered, vector<vector<var_t>> &excluded) {
+    // 相同的强制选项只选择一次，同时被禁止的强制选项没有解
+    vector<vector<uint32_t>> forced = assumptions.forced;
+    sort(forced.begin(), forced.end());
+    forced.erase(unique(forced.begin(), forced.end()), forced.end());
+    columns.assign(assumptions.columns.begin(), assumptions.columns.end());
+    for (const vector<uint32_t> &option : forced) {
+        if (!contains_option(option) ||
+            find(assumptions.forbidden.begin(), assumptions.forbidden.end(),
+                 option) != assumptions.forbidden.end()) {
+            return false;
+        }
+        columns.insert(columns.end(), option.begin(), option.end());
+    }
+    sort(columns.begin(), columns.end());
+    assert(columns.empty() ||
+           (columns.front() > 0 && columns.back() <= (var_t)num_var_));
+
+    for (const vector<uint32_t> &option : assumptions.forbidden) {
+        excluded.emplace_back(option.begin(), option.end());
+    }
+    // 没有上下界时各列至多被覆盖一次；有上下界时每次假设计一次覆盖，
+    // 达到上界的列被覆盖。每个选项至多选择一次，因此强制的选项也被删除
+    if (max_cover_.empty()) {
+        if (adjacent_find(columns.begin(), columns.end()) != columns.end()) {
+            return false;
+        }
+        covered = columns;
+    } else {
+        for (const var_t col : columns) num_covered_[col]++;
+        for (const var_t col : columns) {
+            if (num_covered_[col] > max_cover_[col]) {
+                for (const var_t c : columns) num_covered_[c]--;
+                return false;
+            }
+            if (num_covered_[col] == max_cover_[col] &&
+                (covered.empty() || covered.back() != col)) {
+                covered.push_back(col);
+            }
+        }
+        for (const vector<uint32_t> &option : forced) {
+            excluded.emplace_back(option.begin(), option.end());
+        }
+    }
+    sort(excluded.begin(), excluded.end());
+    excluded.erase(unique(excluded.begin(), excluded.end()), excluded.end());
+    batch_cover(covered.cbegin(), covered.cend());
+    return true;
+}
+
+template <typename Traits>
+void ZddWithLinks<Traits>::restore_assumptions(const vector<var_t> &columns,
+                                               const vector<var_t> &covered) {
+    batch_uncover(covered.cbegin(), covered.cend());
+    if (!max_cover_.empty()) {
+        for (const var_t col : columns) num_covered_[col]--;
+    }
+}
+
+template <typename Traits>
+bool ZddWithLinks<Traits>::live_primary_satisfied() const {
+    // 有上下界时达到下界的主列也可以不再覆盖
+    for (int col = header_[0].right; col != 0; col = header_[col].right) {
+        if (max_cover_.empty() || num_covered_[col] < min_cover_[col]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Traits>
+bool ZddWithLinks<Traits>::contains_option(
+    const vector<uint32_t> &option) const {
+    // 没有隐藏的节点时，有节点的最小列只有根节点
+    index_t node_id = DD_ZERO_TERM;
+    for (int col = 1; col <= num_var_; col++) {
+        if (header_[col].down >= 0) {
+            node_id = header_[col].down;
+            break;
+        }
+    }
+    for (const uint32_t col : option) {
+        while (node_id >= 0 && table_[node_id].var < col) {
+            node_id = table_[node_id].lo;
+        }
+        if (node_id < 0 || table_[node_id].var != col) {
+            node_id = DD_ZERO_TERM;
+            break;
+        }
+        node_id = table_[node_id].hi;
+    }
+    while (node_id >= 0) node_id = table_[node_id].lo;
+    if (node_id == DD_ONE_TERM) return true;
+
+    // ZDD之外的行
+    for (size_t r = 0; r < num_side_rows(); r++) {
+        const index_t begin = side_row_begin_[r];
+        const index_t end = side_row_begin_[r + 1];
+        if ((size_t)(end - begin) != option.size()) continue;
+        index_t c = begin;
+        while (c < end && side_cells_[c].col == option[c - begin]) c++;
+        if (c == end) return true;
+    }
+    return false;
+}
+
+/**
+ * 有覆盖次数的上下界时的搜索
+ * @param solution 当前的部分解。
+ * @param depth 当前搜索深度。
+ * 分支列的节点的每条上方向路径与下方向路径组成一个选项，不覆盖分支列而直接枚举。
+ * 主列在达到上界或在不再选择的分支中被覆盖之前都留在链表中。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::search_with_bounds(vector<vector<var_t>> &solution,
+                                              const int depth) {
+    num_search_tree_nodes++;
+    if (header_[0].right == 0) {  // all primary columns are closed
+        num_solutions += 1;
+        return;
+    }
+
+    // 分支数（选项数，达到下界时加上不再选择的分支）最少的列
+    count_t min_branches = ~count_t(0);
+    int column = -1;
+    for (int pos = header_[0].right; pos != 0; pos = header_[pos].right) {
+        const count_t count = header_[pos].count;
+        const uint32_t need = num_covered_[pos] < min_cover_[pos]
+                                  ? min_cover_[pos] - num_covered_[pos]
+                                  : 0;
+        if (count < need) {
+            num_failure_backtracks++;
+            return;
+        }
+        if (count + 1 - need < min_branches) {
+            column = pos;
+            min_branches = count + 1 - need;
+        }
+    }
+
+    // 已达到下界时，不再选择包含该列的选项
+    if (num_covered_[column] >= min_cover_[column]) {
+        vector<var_t> &closed = depth_choice_buf_[depth];
+        closed.assign(1, column);
+        batch_cover(closed.cbegin(), closed.cend());
+        search_with_bounds(solution, depth + 1);
+        batch_uncover(closed.cbegin(), closed.cend());
+    }
+
+    vector<var_t> &upper = depth_upper_choice_buf_[depth];
+    vector<var_t> &option = depth_option_buf_[depth];
+    for (index_t node_id = header_[column].down; node_id >= 0;) {
+        const auto node = table_[node_id];
+        for (count_t up_id = 0; up_id < node.count_upper; ++up_id) {
+            compute_upper_choice(node_id, up_id, upper);
+            option.assign(upper.rbegin(), upper.rend());
+            option.push_back(column);
+            enumerate_lower_options(node.hi, column, solution, depth);
+        }
+        node_id = node.down;
+    }
+}
+
+template <typename Traits>
+void ZddWithLinks<Traits>::enumerate_lower_options(
+    index_t node_id, var_t column, vector<vector<var_t>> &solution,
+    const int depth) {
+    if (node_id == DD_ONE_TERM) {
+        choose_option_with_bounds(column, solution, depth);
+        return;
+    }
+    // 搜索后结构已恢复，节点的hi/lo和计数不变
+    const auto node = table_[node_id];
+    if (node.count_hi > 0) {
+        depth_option_buf_[depth].push_back(node.var);
+        enumerate_lower_options(node.hi, column, solution, depth);
+        depth_option_buf_[depth].pop_back();
+    }
+    if (node.count_lo > 0) {
+        enumerate_lower_options(node.lo, column, solution, depth);
+    }
+}
+
+template <typename Traits>
+void ZddWithLinks<Traits>::choose_option_with_bounds(
+    var_t column, vector<vector<var_t>> &solution, const int depth) {
+    const vector<var_t> &option = depth_option_buf_[depth];
+    // 包含已分支的列的选项须大于在该列选择的选项
+    for (const var_t col : option) {
+        const int d = min_option_depth_[col];
+        if (d >= 0 && !lexicographical_compare(depth_option_buf_[d].begin(),
+                                               depth_option_buf_[d].end(),
+                                               option.begin(), option.end())) {
+            return;
+        }
+    }
+
+    // 达到上界的列被覆盖
+    vector<var_t> &full = depth_choice_buf_[depth];
+    full.clear();
+    for (const var_t col : option) {
+        if (++num_covered_[col] == max_cover_[col]) full.push_back(col);
+    }
+    const int saved_depth = min_option_depth_[column];
+    min_option_depth_[column] = depth;
+
+    batch_cover(full.cbegin(), full.cend());
+    search_with_bounds(solution, depth + 1);
+    batch_uncover(full.cbegin(), full.cend());
+
+    min_option_depth_[column] = saved_depth;
+    for (const var_t col : option) num_covered_[col]--;
+}
+
+template <typename Traits>
+void ZddWithLinks<Traits>::load_zdd_from_file(const string &file_name) {
+    RawZdd zdd = read_zdd_file(file_name);
+    reduce_zdd(zdd);
+    load_zdd(zdd);
+}
+
+/**
+ * 从已读取的ZDD建立舞动链接结构
+ * @param zdd 读取的ZDD。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::load_zdd(const RawZdd &zdd) {
+    prepare_arena(zdd.nodes.size());
+    for (const RawNode &node : zdd.nodes) {
+        table_.emplace_back(node.var, node.hi, node.lo);
     }
 
-    string line;
+    setup_dancing_links();
+    set_secondary_columns(zdd.secondary);
+    if (!zdd.bounds.empty()) set_column_bounds(zdd.bounds);
+}
 
-    unordered_map<int, int> id_convert_table;
+/**
+ * 把次要列从头部链表移到次要列的链表
+ * @param columns 次要列，升序。大于 num_var_ 的列没有节点，忽略。
+ * 次要列的链表的头部为 header_[num_var_ + 1]。覆盖和取消覆盖在列所在的链表中进行，
+ * 搜索只遍历 header_[0] 的链表，因此只在主列上分支，次要列未被覆盖时也得到解。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::set_secondary_columns(
+    const vector<uint32_t> &columns) {
+    const int head = num_var_ + 1;
+    for (const uint32_t col : columns) {
+        if (col == 0 || col > (uint32_t)num_var_) continue;
+        Header &header = header_[col];
+        header_[header.left].right = header.right;
+        header_[header.right].left = header.left;
+        header.left = header_[head].left;
+        header.right = head;
+        header_[header_[head].left].right = col;
+        header_[head].left = col;
+    }
+}
 
-    while (getline(ifs, line)) {
-        if (line[0] == '.' || line[0] == '\n' || line[0] == '#' || line.size() == 0) continue;
+/**
+ * 建立Arena
+ * @param num_nodes 节点单元数。
+ * 节点单元、头部单元、动态规划管理器和隐藏节点栈的大小在解析后即可确定，
+ * 因此一次性分配一个Arena，并把已有的头部单元移入其中。
+ * 不足一个大页时不使用Arena（例如搜索中提取的小残余子ZDD），直接在堆上分配。
+ * 每个深度的缓冲区随搜索深度增长，仍在堆上分配。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::prepare_arena(size_t num_nodes) {
+    const size_t bytes = NodeTable::arena_size(num_nodes) +
+                         arena_bytes<Header>(header_.size()) +
+                         DpManager::arena_size(num_nodes, num_var_) +
+                         HiddenNodeStack::arena_size(num_nodes);
+    if (bytes < Arena::HUGE_PAGE_SIZE) {
+        table_.reserve(num_nodes);
+        return;
+    }
+    arena_ = make_unique<Arena>(bytes);
+
+    header_ = arena_vector<Header>(header_.begin(), header_.end(),
+                                   ArenaAllocator<Header>(arena_.get()));
+    table_.reserve(num_nodes, arena_.get());
+    hidden_node_stack_->reserve(num_nodes, arena_.get());
+}
 
-        istringstream iss(line);
-        int nid;
-        int var;
-        string lo_str;
-        int lo_id;
-        string hi_str;
-        int hi_id;
-        iss >> nid;
-        iss >> var;
-        iss >> lo_str;
-        iss >> hi_str;
+/**
+ * 各数据结构占用的字节数
+ * @return (名称, 字节数) 的列表。
+ */
+template <typename Traits>
+vector<pair<const char *, size_t>> ZddWithLinks<Traits>::footprint() const {
+    auto result = table_.footprint();
+    result.emplace_back("header cells", header_.capacity() * sizeof(Header));
+    if (!side_cells_.empty()) {
+        result.emplace_back("side row cells",
+                            side_cells_.capacity() * sizeof(SideCell) +
+                                side_row_begin_.capacity() * sizeof(index_t) +
+                                side_count_.capacity() * sizeof(count_t));
+    }
+    if (!max_cover_.empty()) {
+        size_t bytes = (min_cover_.capacity() + max_cover_.capacity() +
+                        num_covered_.capacity()) *
+                           sizeof(uint32_t) +
+                       min_option_depth_.capacity() * sizeof(int);
+        for (int d = 0; d < MAX_DEPTH; d++) {
+            bytes += depth_option_buf_[d].capacity() * sizeof(var_t);
+        }
+        result.emplace_back("column bounds", bytes);
+    }
+    if (dp_mgr_) {
+        for (const auto &entry : dp_mgr_->footprint()) {
+            result.push_back(entry);
+        }
+    }
+    if (hidden_node_stack_) {
+        result.emplace_back("hidden node stack",
+                            hidden_node_stack_->footprint());
+    }
+
+    size_t depth_bufs = 0;
+    for (int d = 0; d < MAX_DEPTH; d++) {
+        depth_bufs += depth_choice_buf_[d].capacity() * sizeof(var_t);
+        depth_bufs += depth_upper_choice_buf_[d].capacity() * sizeof(var_t);
+        depth_bufs += depth_lower_choice_buf_[d].capacity() * sizeof(var_t);
+        depth_bufs += depth_lower_trace_buf_[d].capacity() * sizeof(trace_t);
+        depth_bufs += depth_lower_change_pts_buf_[d].capacity() * sizeof(size_t);
+        depth_bufs += depth_upper_trace_buf_[d].capacity() * sizeof(trace_t);
+        depth_bufs += depth_upper_change_pts_buf_[d].capacity() * sizeof(size_t);
+        depth_bufs +=
+            depth_upper_change_node_ids_buf_[d].capacity() * sizeof(index_t);
+    }
+    result.emplace_back("per-depth buffers (heap)", depth_bufs);
+    return result;
+}
 
-        id_convert_table[nid] = table_.size();
-        if (lo_str[0] == 'B') {
-            lo_id = DD_ZERO_TERM;
-        } else if (lo_str[0] == 'T') {
-            lo_id = DD_ONE_TERM;
+/**
+ * 收集当前残余问题的存活节点
+ * @param column_map 新列编号到原列编号的映射。
+ * @param cells 存活节点的(新var, 新hi, 新lo)。
+ * 按var降序、同一var内按节点id升序输出，子节点总在父节点之前，根节点在最后。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::collect_live_nodes(
+    vector<var_t> &column_map,
+    vector<tuple<var_t, index_t, index_t>> &cells) const {
+    column_map.assign(1, 0);
+    cells.clear();
+    // renumber uncovered columns keeping their order, merging the primary
+    // and the secondary lists (both are in ascending order).
+    const int secondary_head = num_var_ + 1;
+    vector<var_t> new_col(num_var_ + 1, 0);
+    for (int pos = header_[0].right, sec = header_[secondary_head].right;
+         pos != 0 || sec != secondary_head;) {
+        int col;
+        if (sec == secondary_head || (pos != 0 && pos < sec)) {
+            col = pos;
+            pos = header_[pos].right;
         } else {
-            lo_id = id_convert_table[stoi(lo_str)];
+            col = sec;
+            sec = header_[sec].right;
+        }
+        new_col[col] = column_map.size();
+        column_map.push_back(col);
+    }
+
+    vector<index_t> new_id(table_.size(), DD_ZERO_TERM);
+    for (auto it = column_map.rbegin(); it + 1 != column_map.rend(); ++it) {
+        const auto var = *it;
+        for (auto node_id = header_[var].down; node_id >= 0;
+             node_id = table_[node_id].down) {
+            const auto node = table_[node_id];
+            assert(node.count_upper > 0 && node.count_hi > 0);
+            // hidden children are already bypassed by hi/lo.
+            index_t hi_id = node.hi >= 0 ? new_id[node.hi] : node.hi;
+            index_t lo_id = DD_ZERO_TERM;
+            if (node.count_lo > 0) {
+                lo_id = node.lo >= 0 ? new_id[node.lo] : node.lo;
+            }
+            assert(hi_id != DD_ZERO_TERM);
+            assert(node.count_lo == 0 || lo_id != DD_ZERO_TERM);
+            new_id[node_id] = cells.size();
+            cells.emplace_back(new_col[var], hi_id, lo_id);
+        }
+    }
+}
+
+/**
+ * 设置各列的覆盖次数的上下界
+ * @param bounds 上下界，按列升序。
+ * 主列的下界默认为1，次要列为0，上界默认为1。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::set_column_bounds(
+    const vector<ColumnBounds> &bounds) {
+    min_cover_.assign(num_var_ + 1, 1);
+    max_cover_.assign(num_var_ + 1, 1);
+    for (int pos = header_[num_var_ + 1].right; pos != num_var_ + 1;
+         pos = header_[pos].right) {
+        min_cover_[pos] = 0;
+    }
+    for (const ColumnBounds &b : bounds) {
+        if (b.column > (uint32_t)num_var_) continue;
+        assert((b.lower == 0) == (min_cover_[b.column] == 0));
+        min_cover_[b.column] = b.lower;
+        max_cover_[b.column] = b.upper;
+    }
+    num_covered_.assign(num_var_ + 1, 0);
+    min_option_depth_.assign(num_var_ + 1, -1);
+    depth_option_buf_.assign(MAX_DEPTH, vector<var_t>());
+}
+
+/**
+ * 未覆盖的次要列的新编号
+ * @param column_map collect_live_nodes 输出的新列编号到原列编号的映射。
+ * @return 新编号，升序。
+ */
+template <typename Traits>
+vector<uint32_t> ZddWithLinks<Traits>::live_secondary_columns(
+    const vector<var_t> &column_map) const {
+    vector<uint32_t> columns;
+    for (int pos = header_[num_var_ + 1].right; pos != num_var_ + 1;
+         pos = header_[pos].right) {
+        columns.push_back(
+            lower_bound(column_map.begin() + 1, column_map.end(), pos) -
+            column_map.begin());
+    }
+    return columns;
+}
+
+/**
+ * 提取当前残余问题的紧凑子ZDD
+ * @param excluded 不放入子ZDD的选项。
+ * @return 新的ZddWithLinks，若不存在存活节点则返回 nullptr。
+ */
+template <typename Traits>
+unique_ptr<ZddWithLinks<Traits>> ZddWithLinks<Traits>::extract_residual(
+    const vector<vector<var_t>> &excluded) const {
+    vector<var_t> column_map;
+    vector<tuple<var_t, index_t, index_t>> cells;
+    collect_live_nodes(column_map, cells);
+    SideRows rows;
+    collect_live_side_rows(column_map, rows);
+    if (!excluded.empty()) {
+        remove_live_options(column_map, excluded, cells, rows);
+    }
+    if (cells.empty() && rows.num_rows() == 0) {
+        return nullptr;
+    }
+
+    auto residual =
+        make_unique<ZddWithLinks>(column_map.size() - 1, sanity_check_);
+    residual->decompose_interval_ = decompose_interval_;
+    residual->component_cache_ = component_cache_;
+    residual->prepare_arena(cells.size());
+    for (const auto &[var, hi_id, lo_id] : cells) {
+        residual->table_.emplace_back(var, hi_id, lo_id);
+    }
+    residual->setup_dancing_links();
+    residual->set_secondary_columns(live_secondary_columns(column_map));
+    residual->load_side_rows(rows);
+    if (!max_cover_.empty()) {
+        // 存活的列保留上下界和已选择的次数
+        vector<ColumnBounds> bounds;
+        for (size_t col = 1; col < column_map.size(); col++) {
+            const var_t orig = column_map[col];
+            bounds.push_back(
+                {(uint32_t)col, min_cover_[orig], max_cover_[orig]});
+        }
+        residual->set_column_bounds(bounds);
+        for (size_t col = 1; col < column_map.size(); col++) {
+            residual->num_covered_[col] = num_covered_[column_map[col]];
+        }
+    }
+    return residual;
+}
+
+/**
+ * 从收集的存活节点和行中删除给定的选项
+ * @param column_map 新列编号到原列编号的映射。
+ * @param options 要删除的选项（原列编号）。含已覆盖的列的选项不在残余问题中，被忽略。
+ * @param cells 存活节点，原地修改，仍按var降序、根节点在最后。
+ * @param rows 存活的ZDD之外的行，原地修改。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::remove_live_options(
+    const vector<var_t> &column_map, const vector<vector<var_t>> &options,
+    vector<tuple<var_t, index_t, index_t>> &cells, SideRows &rows) {
+    vector<vector<uint32_t>> mapped;
+    for (const vector<var_t> &option : options) {
+        vector<uint32_t> columns;
+        for (const var_t col : option) {
+            auto it = lower_bound(column_map.begin() + 1, column_map.end(), col);
+            if (it == column_map.end() || *it != col) break;
+            columns.push_back(it - column_map.begin());
+        }
+        if (columns.size() == option.size()) mapped.push_back(columns);
+    }
+    if (mapped.empty()) return;
+    sort(mapped.begin(), mapped.end());
+
+    if (!cells.empty()) {
+        RawZdd zdd;
+        zdd.num_var = column_map.size() - 1;
+        zdd.nodes.reserve(cells.size());
+        for (const auto &[var, hi_id, lo_id] : cells) {
+            zdd.nodes.push_back({(uint32_t)var, hi_id, lo_id});
+        }
+        remove_options(zdd, mapped);
+        cells.clear();
+        for (const RawNode &node : zdd.nodes) {
+            cells.emplace_back((var_t)node.var, (index_t)node.hi,
+                               (index_t)node.lo);
+        }
+    }
+
+    SideRows kept;
+    vector<uint32_t> row;
+    for (size_t r = 0; r < rows.num_rows(); r++) {
+        row.assign(rows.elements.begin() + rows.offsets[r],
+                   rows.elements.begin() + rows.offsets[r + 1]);
+        if (binary_search(mapped.begin(), mapped.end(), row)) continue;
+        kept.elements.insert(kept.elements.end(), row.begin(), row.end());
+        kept.offsets.push_back(kept.elements.size());
+    }
+    rows = std::move(kept);
+}
+
+/**
+ * 加载ZDD之外的行
+ * @param rows 各行的列（升序）。
+ * 单元 0..num_var_ 为各列的循环链表的头部，各行的单元依次追加到所在列的链表末尾。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::load_side_rows(const SideRows &rows) {
+    if (rows.num_rows() == 0) return;
+    side_cells_.resize(num_var_ + 1);
+    for (int col = 0; col <= num_var_; col++) {
+        side_cells_[col] = {(var_t)col, col, col, -1};
+    }
+    side_cells_.reserve(num_var_ + 1 + rows.elements.size());
+    side_count_.assign(num_var_ + 1, 0);
+    side_row_begin_.assign(1, side_cells_.size());
+    for (size_t r = 0; r < rows.num_rows(); r++) {
+        for (uint64_t k = rows.offsets[r]; k < rows.offsets[r + 1]; k++) {
+            const var_t col = rows.elements[k];
+            const index_t cell = side_cells_.size();
+            const index_t last = side_cells_[col].up;
+            side_cells_.push_back({col, last, (index_t)col, (index_t)r});
+            side_cells_[last].down = cell;
+            side_cells_[col].up = cell;
+            side_count_[col]++;
+            header_[col].count += 1;
+        }
+        side_row_begin_.push_back(side_cells_.size());
+    }
+}
+
+template <typename Traits>
+void ZddWithLinks<Traits>::side_cover(var_t col) {
+    for (index_t cell = side_cells_[col].down; cell != col;
+         cell = side_cells_[cell].down) {
+        const index_t row = side_cells_[cell].row;
+        for (index_t c = side_row_begin_[row]; c < side_row_begin_[row + 1];
+             c++) {
+            if (c == cell) continue;
+            const SideCell &other = side_cells_[c];
+            side_cells_[other.up].down = other.down;
+            side_cells_[other.down].up = other.up;
+            side_count_[other.col]--;
+            header_[other.col].count -= 1;
+            num_updates++;
+        }
+    }
+}
+
+template <typename Traits>
+void ZddWithLinks<Traits>::side_uncover(var_t col) {
+    for (index_t cell = side_cells_[col].up; cell != col;
+         cell = side_cells_[cell].up) {
+        const index_t row = side_cells_[cell].row;
+        for (index_t c = side_row_begin_[row + 1]; c-- > side_row_begin_[row];) {
+            if (c == cell) continue;
+            const SideCell &other = side_cells_[c];
+            side_cells_[other.up].down = c;
+            side_cells_[other.down].up = c;
+            side_count_[other.col]++;
+            header_[other.col].count += 1;
+        }
+    }
+}
+
+template <typename Traits>
+int ZddWithLinks<Traits>::choose_column_with_side_rows() const {
+    int column = -1, zero_column = -1;
+    count_t min_zdd_count = ~count_t(0), min_zero_count = ~count_t(0);
+    for (int pos = header_[0].right; pos != 0; pos = header_[pos].right) {
+        const count_t count = header_[pos].count;
+        const count_t zdd_count = count - side_count_[pos];
+        if (zdd_count == 0) {
+            if (count < min_zero_count) {
+                zero_column = pos;
+                min_zero_count = count;
+            }
+        } else if (zdd_count < min_zdd_count) {
+            column = pos;
+            min_zdd_count = zdd_count;
+        }
+    }
+    return zero_column >= 0 ? zero_column : column;
+}
+
+/**
+ * 收集存活的ZDD之外的行
+ * @param column_map 新列编号到原列编号的映射。
+ * @param rows 存活的行，列为新编号。
+ * 存活的行的所有单元都在链表中，在其最小列的链表中取出一次。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::collect_live_side_rows(
+    const vector<var_t> &column_map, SideRows &rows) const {
+    rows = SideRows();
+    if (side_cells_.empty()) return;
+    vector<var_t> new_col(num_var_ + 1, 0);
+    for (size_t c = 1; c < column_map.size(); c++) new_col[column_map[c]] = c;
+    for (size_t c = 1; c < column_map.size(); c++) {
+        const var_t col = column_map[c];
+        for (index_t cell = side_cells_[col].down; cell != col;
+             cell = side_cells_[cell].down) {
+            const index_t row = side_cells_[cell].row;
+            if (side_row_begin_[row] != cell) continue;
+            for (index_t k = side_row_begin_[row]; k < side_row_begin_[row + 1];
+                 k++) {
+                rows.elements.push_back(new_col[side_cells_[k].col]);
+            }
+            rows.offsets.push_back(rows.elements.size());
+        }
+    }
+}
+
+template <typename Traits>
+void ZddWithLinks<Traits>::set_decompose_interval(int interval,
+                                                  size_t cache_bytes) {
+    decompose_interval_ = interval;
+    component_cache_ =
+        interval >= 0 ? make_shared<ComponentCache>(cache_bytes) : nullptr;
+}
+
+/**
+ * 按连通分量分解残余问题并计数
+ * @param solution 当前的部分解。
+ * @param depth 当前搜索深度。
+ * @return 进行了分解时返回 true。
+ * 列的连通关系由存活节点直接求得：节点与其hi子节点的列在同一选项中，
+ * 从hi边到达的节点经lo链到达的节点也与该节点在同一选项中（父节点在前的顺序传播标记）。
+ */
+template <typename Traits>
+bool ZddWithLinks<Traits>::count_by_components(
+    vector<vector<var_t>> &solution, const int depth) {
+    vector<var_t> column_map;
+    vector<tuple<var_t, index_t, index_t>> cells;
+    collect_live_nodes(column_map, cells);
+    SideRows rows;
+    collect_live_side_rows(column_map, rows);
+    const size_t num_cols = column_map.size() - 1;
+    vector<bool> is_secondary(num_cols + 1, false);
+    for (const uint32_t col : live_secondary_columns(column_map)) {
+        is_secondary[col] = true;
+    }
+
+    // union-find over the new column ids.
+    vector<uint32_t> parent(num_cols + 1);
+    iota(parent.begin(), parent.end(), 0);
+    auto find = [&](uint32_t x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    };
+    auto unite = [&](uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b) parent[max(a, b)] = min(a, b);
+    };
+    // in_option[k]: 节点k经某个祖先的hi边到达（其列与该祖先的列同在一个选项中）
+    vector<bool> in_option(cells.size(), false);
+    for (size_t k = cells.size(); k-- > 0;) {
+        const auto [var, hi_id, lo_id] = cells[k];
+        if (hi_id >= 0) {
+            unite(var, get<0>(cells[hi_id]));
+            in_option[hi_id] = true;
         }
-        if (hi_str[0] == 'B') {
-            hi_id = DD_ZERO_TERM;
-        } else if (hi_str[0] == 'T') {
-            hi_id = DD_ONE_TERM;
+        if (in_option[k] && lo_id >= 0) {
+            unite(var, get<0>(cells[lo_id]));
+            in_option[lo_id] = true;
+        }
+    }
+    for (size_t r = 0; r < rows.num_rows(); r++) {
+        for (uint64_t k = rows.offsets[r] + 1; k < rows.offsets[r + 1]; k++) {
+            unite(rows.elements[k - 1], rows.elements[k]);
+        }
+    }
+
+    // 各分量内的列按原顺序重新编号
+    vector<uint32_t> comp_of(num_cols + 1, 0), local_col(num_cols + 1, 0);
+    vector<uint32_t> comp_size;
+    vector<vector<uint32_t>> comp_secondary;
+    for (size_t c = 1; c <= num_cols; c++) {
+        const uint32_t root = find(c);
+        if (root == c) {
+            comp_of[c] = comp_size.size();
+            comp_size.push_back(0);
+            comp_secondary.emplace_back();
         } else {
-            hi_id = id_convert_table[stoi(hi_str)];
+            comp_of[c] = comp_of[root];
+        }
+        local_col[c] = ++comp_size[comp_of[c]];
+        if (is_secondary[c]) {
+            comp_secondary[comp_of[c]].push_back(local_col[c]);
         }
-        table_.emplace_back(var, hi_id, lo_id);
     }
+    if (comp_size.size() <= 1) return false;
+    num_decompositions++;
+    vector<SideRows> comp_rows(comp_size.size());
+    for (size_t r = 0; r < rows.num_rows(); r++) {
+        SideRows &dest = comp_rows[comp_of[rows.elements[rows.offsets[r]]]];
+        for (uint64_t k = rows.offsets[r]; k < rows.offsets[r + 1]; k++) {
+            dest.elements.push_back(local_col[rows.elements[k]]);
+        }
+        dest.offsets.push_back(dest.elements.size());
+    }
+
+    const count128_t saved_solutions = num_solutions;
+    count128_t product = 1;
+    vector<int64_t> ids(cells.size());
+    for (size_t comp = 0; comp < comp_size.size() && product != 0; comp++) {
+        // 只有次要列的分量只有不选任何选项一个解
+        if (comp_secondary[comp].size() == comp_size[comp]) continue;
+        // 不属于该分量的节点取lo，即不选其列的选项
+        RawZdd zdd;
+        zdd.num_var = comp_size[comp];
+        zdd.secondary = move(comp_secondary[comp]);
+        UniqueTable unique(zdd.nodes);
+        auto map_id = [&](index_t id) -> int64_t {
+            return id >= 0 ? ids[id] : id;
+        };
+        for (size_t k = 0; k < cells.size(); k++) {
+            const auto [var, hi_id, lo_id] = cells[k];
+            ids[k] = comp_of[var] == comp
+                         ? unique.get(local_col[var], map_id(lo_id),
+                                      map_id(hi_id))
+                         : map_id(lo_id);
+        }
+        const int64_t root = ids.empty() ? DD_ZERO_TERM : ids.back();
+        const SideRows &sub_rows = comp_rows[comp];
+        if (root < 0 && sub_rows.num_rows() == 0) {
+            // 该分量的列无法覆盖
+            product = 0;
+            break;
+        }
+        if (root >= 0) {
+            assert((size_t)root + 1 == zdd.nodes.size());
+            sort_nodes_by_var(zdd);
+        } else {
+            // 只有ZDD之外的行（⊤表示的空选项对覆盖没有作用）
+            zdd.nodes.clear();
+        }
 
-    setup_dancing_links();
+        string key;
+        key.reserve(sizeof(uint32_t) + zdd.nodes.size() * sizeof(RawNode));
+        key.append((const char *)&zdd.num_var, sizeof(zdd.num_var));
+        const uint32_t num_secondary = zdd.secondary.size();
+        key.append((const char *)&num_secondary, sizeof(num_secondary));
+        key.append((const char *)zdd.secondary.data(),
+                   num_secondary * sizeof(uint32_t));
+        for (const RawNode &node : zdd.nodes) {
+            key.append((const char *)&node.var, sizeof(node.var));
+            key.append((const char *)&node.hi, sizeof(node.hi));
+            key.append((const char *)&node.lo, sizeof(node.lo));
+        }
+        for (size_t r = 0; r < sub_rows.num_rows(); r++) {
+            const uint32_t len = sub_rows.offsets[r + 1] - sub_rows.offsets[r];
+            key.append((const char *)&len, sizeof(len));
+            key.append((const char *)&sub_rows.elements[sub_rows.offsets[r]],
+                       len * sizeof(uint32_t));
+        }
+        count128_t count;
+        if (!component_cache_->lookup(key, count)) {
+            ZddWithLinks sub(zdd.num_var, sanity_check_);
+            sub.parallel_level_threshold_ = parallel_level_threshold_;
+            sub.parallel_setup_threshold_ = parallel_setup_threshold_;
+            sub.decompose_interval_ = decompose_interval_;
+            sub.skip_decompose_depth_ = depth;
+            sub.component_cache_ = component_cache_;
+            sub.load_zdd(zdd);
+            sub.load_side_rows(sub_rows);
+            const count128_t before = num_solutions;
+            sub.search(solution, depth);
+            count = num_solutions - before;
+            component_cache_->insert(key, count);
+        }
+        if (__builtin_mul_overflow(product, count, &product)) {
+            cerr << "error: number of solutions exceeds 128 bits" << endl;
+            exit(1);
+        }
+    }
+    if (__builtin_add_overflow(saved_solutions, product, &num_solutions)) {
+        cerr << "error: number of solutions exceeds 128 bits" << endl;
+        exit(1);
+    }
+    return true;
+}
+
+/**
+ * 将当前残余问题的存活节点写入文件
+ * @param file_name 输出的ZDD文件名。
+ * @param excluded 不写入的选项。
+ * @return 没有存活节点，或有不在任何选项中的存活主列（无解）时不写入并返回 false。
+ * 输出格式与 load_zdd_from_file 读取的Graphillion格式相同，列映射写入 file_name.map，
+ * 存活的次要列写入 file_name.secondary。
+ */
+template <typename Traits>
+bool ZddWithLinks<Traits>::write_zdd_to_file(
+    const string &file_name, const vector<vector<var_t>> &excluded) const {
+    if (!side_cells_.empty()) {
+        cerr << "can't write a zdd file of a structure having side rows"
+             << endl;
+        exit(1);
+    }
+    vector<var_t> column_map;
+    vector<tuple<var_t, index_t, index_t>> cells;
+    collect_live_nodes(column_map, cells);
+    if (!excluded.empty()) {
+        SideRows rows;
+        remove_live_options(column_map, excluded, cells, rows);
+    }
+    if (cells.empty()) return false;
+    // 不在任何选项中的主列不会出现在ZDD文件中，这样的残余问题无解
+    vector<bool> has_node(column_map.size(), false);
+    for (const auto &cell : cells) has_node[get<0>(cell)] = true;
+    for (int col = header_[0].right; col != 0; col = header_[col].right) {
+        auto it = lower_bound(column_map.begin() + 1, column_map.end(),
+                              (var_t)col);
+        if (!has_node[it - column_map.begin()]) return false;
+    }
+
+    RawZdd zdd;
+    zdd.num_var = column_map.size() - 1;
+    zdd.nodes.reserve(cells.size());
+    for (const auto &[var, hi_id, lo_id] : cells) {
+        zdd.nodes.push_back({(uint32_t)var, hi_id, lo_id});
+    }
+    write_zdd_file(zdd, file_name);
+
+    // 与 zdd_reorder 的列映射文件格式相同，可以用 zdd_reorder -t 换回原来的列
+    ofstream map_ofs(file_name + ".map");
+    if (!map_ofs) {
+        cerr << "can't open " << file_name << ".map" << endl;
+        exit(1);
+    }
+    for (size_t col = 1; col < column_map.size(); col++) {
+        map_ofs << col << " " << column_map[col] << "\n";
+    }
+    // 读取ZDD文件时会自动读取旁边的 .secondary，因此没有次要列时删除旧的文件
+    const vector<uint32_t> secondary = live_secondary_columns(column_map);
+    const string secondary_file = file_name + ".secondary";
+    if (secondary.empty()) {
+        remove(secondary_file.c_str());
+        return true;
+    }
+    ofstream sec_ofs(secondary_file);
+    if (!sec_ofs) {
+        cerr << "can't open " << secondary_file << endl;
+        exit(1);
+    }
+    for (const uint32_t col : secondary) sec_ofs << col << "\n";
+    return true;
+}
+
+/**
+ * 写入快照文件
+ * @param file_name 快照文件名。
+ * 头部单元和节点单元的各数组按Arena的分配规则（64字节对齐）排列，
+ * 使 load_snapshot 能以相同的顺序从映射中取得。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::write_snapshot(const string &file_name) const {
+    if (!side_cells_.empty()) {
+        cerr << "can't write a snapshot of a structure having side rows"
+             << endl;
+        exit(1);
+    }
+    ofstream ofs(file_name, ios::binary);
+    if (!ofs) {
+        cerr << "can't open " << file_name << endl;
+        exit(1);
+    }
+
+    vector<pair<const void *, size_t>> arrays;
+    arrays.emplace_back(header_.data(), header_.size() * sizeof(Header));
+    table_.for_each_snapshot_array([&arrays](const void *data, size_t bytes) {
+        arrays.emplace_back(data, bytes);
+    });
+    uint64_t data_bytes = 0;
+    for (const auto &[data, bytes] : arrays) {
+        data_bytes = ((data_bytes + 63) & ~63UL) + bytes;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.count_bytes = sizeof(count_t);
+    header.index_bytes = sizeof(index_t);
+    header.var_bytes = sizeof(var_t);
+    header.num_var = num_var_;
+    header.num_nodes = table_.size();
+    header.data_bytes = data_bytes;
+
+    const vector<char> padding(SNAPSHOT_DATA_OFFSET, 0);
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    ofs.write(padding.data(), SNAPSHOT_DATA_OFFSET - sizeof(header));
+    uint64_t pos = 0;
+    for (const auto &[data, bytes] : arrays) {
+        const uint64_t aligned = (pos + 63) & ~63UL;
+        ofs.write(padding.data(), aligned - pos);
+        ofs.write(static_cast<const char *>(data), bytes);
+        pos = aligned + bytes;
+    }
+    if (!ofs) {
+        cerr << "failed to write " << file_name << endl;
+        exit(1);
+    }
+}
+
+/**
+ * 从快照文件加载
+ * @param file_name 快照文件名。
+ * 以MAP_PRIVATE映射整个文件作为Arena，头部单元和节点单元直接使用映射中的数据，
+ * 搜索中写入的页才会被复制。动态规划管理器和隐藏节点栈只包含工作区，在堆上重新建立。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::load_snapshot(const string &file_name) {
+    const SnapshotHeader header = read_snapshot_header(file_name);
+    if (header.count_bytes != sizeof(count_t) ||
+        header.index_bytes != sizeof(index_t) ||
+        header.var_bytes != sizeof(var_t) ||
+        header.num_var != (uint64_t)num_var_) {
+        cerr << "snapshot " << file_name << " does not match the widths "
+             << "or the number of variables" << endl;
+        exit(1);
+    }
+
+    arena_ = make_unique<Arena>(file_name, SNAPSHOT_DATA_OFFSET);
+    header_ = arena_vector<Header>(num_var_ + 2,
+                                   ArenaAllocator<Header>(arena_.get()));
+    table_.adopt(header.num_nodes, arena_.get());
+    if (arena_->used() != header.data_bytes) {
+        cerr << "inconsistent layout in snapshot " << file_name << endl;
+        exit(1);
+    }
+
+    hidden_node_stack_->reserve(header.num_nodes, nullptr);
+    dp_mgr_ = make_unique<DpManager>(table_, num_var_);
 }
 
 /**
@@ -236,9 +1316,10 @@ void ZddWithLinks::load_zdd_from_file(const string &file_name) {
  * @param col_end 列结束的迭代器。
  * 通过覆盖列来更新数据结构，隐藏相关节点。
  */
-void ZddWithLinks::batch_cover(
-    const std::vector<uint16_t>::const_iterator col_begin,
-    const std::vector<uint16_t>::const_iterator col_end) {
+template <typename Traits>
+void ZddWithLinks<Traits>::batch_cover(
+    const col_iterator col_begin,
+    const col_iterator col_end) {
     // 确保列是按顺序排列的
     assert(is_sorted(col_begin, col_end));
     // 如果没有列需要覆盖，直接返回
@@ -279,7 +1360,7 @@ void ZddWithLinks::batch_cover(
                 for (auto node_id = header_[var].down; node_id >= 0;
                      node_id = table_[node_id].down) {
                     num_updates++;
-                    Node &node = table_[node_id];
+                    auto node = table_[node_id];
                     // 确保节点的上方向和高方向计数大于0
                     assert(node.count_upper > 0);
                     assert(node.count_hi > 0);
@@ -333,7 +1414,7 @@ void ZddWithLinks::batch_cover(
                     num_updates++;
 
                     const auto node_id = dp_mgr_->at(var, i);
-                    Node &node = table_[node_id];
+                    auto node = table_[node_id];
                     // 确保节点的上方向计数大于0
                     assert(node.count_upper > 0);
                     // 获取并清除节点的上方向计数差异
@@ -399,7 +1480,7 @@ void ZddWithLinks::batch_cover(
             for (auto node_id = header_[var].down; node_id >= 0;
                  node_id = table_[node_id].down) {
                 num_updates++;
-                Node &node = table_[node_id];
+                auto node = table_[node_id];
 
                 assert(node.count_hi > 0);
                 assert(dp_mgr_->high_count_at(node_id) == 0);
@@ -411,7 +1492,7 @@ void ZddWithLinks::batch_cover(
                         for (auto plink = node.parents_head;;
                              plink = plink_get_next(plink)) {
                             const auto parent_id = plink_node_id(plink);
-                            const Node &parent = table_[parent_id];
+                            const auto parent = table_[parent_id];
 
                             if (plink_is_hi(plink)) {
                                 dp_mgr_->add_node_diff_count_high(
@@ -429,6 +1510,10 @@ void ZddWithLinks::batch_cover(
 
                 hidden_node_stack_->push_cover_up(node_id);
             }
+        } else if (parallel_level_threshold_ > 0 &&
+                   (size_t)dp_mgr_->num_elems(var) >=
+                       parallel_level_threshold_) {
+            process_upper_level_parallel(var, true);
         } else {  // var is not cover column
             Header &var_head = header_[var];
 
@@ -439,7 +1524,7 @@ void ZddWithLinks::batch_cover(
                     dp_mgr_->get_low_count_and_clear(node_id);
                 const auto high_count =
                     dp_mgr_->get_high_count_and_clear(node_id);
-                Node &node = table_[node_id];
+                auto node = table_[node_id];
 
                 auto c_hi = node.count_hi, c_lo = node.count_lo;
                 if (node.count_hi == 0) {
@@ -461,7 +1546,7 @@ void ZddWithLinks::batch_cover(
                         auto parent_id = plink_node_id(plink);
                         assert(parent_id != node_id);
 
-                        Node &parent = table_[parent_id];
+                        auto parent = table_[parent_id];
                         // activeでない1枝経由の伝播はスキップ
                         // 上流からのカウントがゼロのparentはスキップ．
 
@@ -500,7 +1585,7 @@ void ZddWithLinks::batch_cover(
          it != hidden_node_stack_->stack_cend(); ++it) {
         auto [node_id, hide_type] = *it;
 
-        Node &node = table_[node_id];
+        auto node = table_[node_id];
         auto nup = node.up, ndown = node.down;
 
         switch (hide_type) {
@@ -529,11 +1614,17 @@ void ZddWithLinks::batch_cover(
                 exit(1);
         }
     }
+    if (!side_cells_.empty()) {
+        for (auto it = col_begin; it != col_end; ++it) {
+            side_cover(*it);
+        }
+    }
 }
 
-void ZddWithLinks::batch_uncover(
-    const std::vector<uint16_t>::const_iterator col_begin,
-    const std::vector<uint16_t>::const_iterator col_end) {
+template <typename Traits>
+void ZddWithLinks<Traits>::batch_uncover(
+    const col_iterator col_begin,
+    const col_iterator col_end) {
     assert(is_sorted(col_begin, col_end));
     if (col_begin == col_end) {
         return;
@@ -543,9 +1634,14 @@ void ZddWithLinks::batch_uncover(
     //     cerr << *it << ",";
     // }
     //    cerr << endl;
-    // unhide column headers
     const auto col_rbegin = std::make_reverse_iterator(col_end);
     const auto col_rend = std::make_reverse_iterator(col_begin);
+    if (!side_cells_.empty()) {
+        for (auto it = col_rbegin; it != col_rend; ++it) {
+            side_uncover(*it);
+        }
+    }
+    // unhide column headers
     for (auto it = col_rbegin; it != col_rend; ++it) {
         auto col = *it;
         auto left = header_[col].left, right = header_[col].right;
@@ -609,7 +1705,7 @@ void ZddWithLinks::batch_uncover(
 
                 for (auto node_id = header_[var].down; node_id >= 0;
                      node_id = table_[node_id].down) {
-                    Node &node = table_[node_id];
+                    auto node = table_[node_id];
                     assert(node.count_hi > 0);
                     assert(dp_mgr_->high_count_at(node_id) == 0);
 
@@ -622,7 +1718,7 @@ void ZddWithLinks::batch_uncover(
                              plink = plink_get_next(plink)) {
                             const auto parent_id = plink_node_id(plink);
                             count_t pcount_upper;
-                            uint16_t pvar;
+                            var_t pvar;
                             pcount_upper = table_[parent_id].count_upper,
                             pvar = table_[parent_id].var;
 
@@ -643,6 +1739,10 @@ void ZddWithLinks::batch_uncover(
                         }
                     }
                 }
+            } else if (parallel_level_threshold_ > 0 &&
+                       (size_t)dp_mgr_->num_elems(var) >=
+                           parallel_level_threshold_) {
+                process_upper_level_parallel(var, false);
             } else {  // var is not a covered column
                 Header &var_head = header_[var];
 
@@ -653,7 +1753,7 @@ void ZddWithLinks::batch_uncover(
                     const auto high_count =
                         dp_mgr_->get_high_count_and_clear(node_id);
 
-                    Node &node = table_[node_id];
+                    auto node = table_[node_id];
                     assert(node.count_upper > 0);
                     node.count_lo += low_count, node.count_hi += high_count;
 
@@ -665,7 +1765,7 @@ void ZddWithLinks::batch_uncover(
                             auto parent_id = plink_node_id(plink);
                             assert(parent_id != node_id);
                             count_t pcount_upper;
-                            uint16_t pvar;
+                            var_t pvar;
                             pcount_upper = table_[parent_id].count_upper,
                             pvar = table_[parent_id].var;
                             if (pcount_upper > 0) {
@@ -698,9 +1798,9 @@ void ZddWithLinks::batch_uncover(
             case HiddenNodeStack::HideType::CoverDown:
                 unhide_node_cover_down(node_id);
                 {
-                    int32_t nup, ndown;
+                    index_t nup, ndown;
                     count_t cupper;
-                    uint16_t nvar;
+                    var_t nvar;
                     nup = table_[node_id].up, ndown = table_[node_id].down;
                     cupper = table_[node_id].count_upper,
                     nvar = table_[node_id].var;
@@ -730,7 +1830,7 @@ void ZddWithLinks::batch_uncover(
                 unhide_node_upperzero(node_id);
 
                 {
-                    Node &node = table_[node_id];
+                    auto node = table_[node_id];
                     auto nup = node.up, ndown = node.down;
 
                     if (nup >= 0) {
@@ -769,7 +1869,7 @@ void ZddWithLinks::batch_uncover(
 
                 for (auto node_id = header_[var].down; node_id >= 0;
                      node_id = table_[node_id].down) {
-                    Node &node = table_[node_id];
+                    auto node = table_[node_id];
 
                     assert(node.count_hi > 0);
 
@@ -793,7 +1893,7 @@ void ZddWithLinks::batch_uncover(
                 auto &var_head = header_[var];
                 for (size_t i = 0; i < dp_mgr_->num_elems(var); i++) {
                     const auto node_id = dp_mgr_->at(var, i);
-                    Node &node = table_[node_id];
+                    auto node = table_[node_id];
 
                     const auto upper_count =
                         dp_mgr_->get_count_and_clear(node_id);
@@ -821,20 +1921,128 @@ void ZddWithLinks::batch_uncover(
         }
     }
 }
+/**
+ * 分块并行处理上方向扫描中非覆盖列的一层
+ * @param var 变量编号。
+ * @param cover true时为 batch_cover 的处理，false时为 batch_uncover 的处理。
+ * 各块只修改本层节点的计数，向父节点的传播先记录在块的缓冲区中，
+ * 之后按块的顺序串行地加入动态规划管理器，因此父节点的处理顺序和隐藏节点栈与串行处理相同。
+ */
+template <typename Traits>
+void ZddWithLinks<Traits>::process_upper_level_parallel(var_t var, bool cover) {
+    const size_t n = dp_mgr_->num_elems(var);
+#ifdef _OPENMP
+    const size_t num_chunks = min<size_t>(n, 4 * omp_get_max_threads());
+#else
+    const size_t num_chunks = 1;
+#endif
+    if (level_chunks_.size() < num_chunks) level_chunks_.resize(num_chunks);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t c = 0; c < num_chunks; c++) {
+        LevelChunk &chunk = level_chunks_[c];
+        chunk.diffs.clear();
+        chunk.hides.clear();
+        chunk.head_delta = 0;
+        chunk.num_updates = 0;
+        chunk.num_inactive_updates = 0;
+
+        for (size_t i = n * c / num_chunks; i < n * (c + 1) / num_chunks; i++) {
+            const auto node_id = dp_mgr_->at(var, i);
+            const auto low_count = dp_mgr_->get_low_count_and_clear(node_id);
+            const auto high_count = dp_mgr_->get_high_count_and_clear(node_id);
+            auto node = table_[node_id];
+            assert(node.count_upper > 0);
+
+            if (cover) {
+                chunk.num_updates++;
+                if (node.count_hi == 0) chunk.num_inactive_updates++;
+                node.count_hi -= high_count, node.count_lo -= low_count;
+                if (high_count > 0 && node.count_hi == 0) {
+                    chunk.hides.push_back(node_id);
+                }
+            } else {
+                node.count_lo += low_count, node.count_hi += high_count;
+            }
+            chunk.head_delta += node.count_upper * high_count;
+
+            if (plink_is_term(node.parents_head)) continue;
+            for (plink_t plink = node.parents_head;;
+                 plink = plink_get_next(plink)) {
+                const auto parent_id = plink_node_id(plink);
+                const auto parent = table_[parent_id];
+                if (parent.count_upper > 0) {
+                    chunk.diffs.push_back({(index_t)parent_id,
+                                           high_count + low_count, parent.var,
+                                           plink_is_hi(plink)});
+                } else if (cover) {
+                    chunk.num_inactive_updates++;
+                }
+                if (plink == node.parents_tail) break;
+            }
+        }
+    }
+
+    Header &var_head = header_[var];
+    for (size_t c = 0; c < num_chunks; c++) {
+        const LevelChunk &chunk = level_chunks_[c];
+        for (const ParentDiff &diff : chunk.diffs) {
+            if (diff.is_hi) {
+                dp_mgr_->add_node_diff_count_high(diff.parent_var,
+                                                  diff.parent_id, diff.count);
+            } else {
+                dp_mgr_->add_node_diff_count_low(diff.parent_var,
+                                                 diff.parent_id, diff.count);
+            }
+        }
+        for (const index_t node_id : chunk.hides) {
+            num_hides++;
+            hidden_node_stack_->push_lowerzero(node_id);
+        }
+        if (cover) {
+            var_head.count -= chunk.head_delta;
+        } else {
+            var_head.count += chunk.head_delta;
+        }
+        num_updates += chunk.num_updates;
+        num_inactive_updates += chunk.num_inactive_updates;
+    }
+}
+
 /**
  * 设置舞动链接结构，初始化节点计数和链接关系。
  * 初始化节点的计数和链接关系，准备动态规划管理器。
  */
-void ZddWithLinks::setup_dancing_links() {
+template <typename Traits>
+void ZddWithLinks<Traits>::setup_dancing_links() {
+#ifdef _OPENMP
+    const bool parallel = parallel_setup_threshold_ > 0 &&
+                          table_.size() >= parallel_setup_threshold_ &&
+                          omp_get_max_threads() > 1;
+#else
+    const bool parallel = false;
+#endif
+    if (parallel) {
+        setup_links_parallel();
+    } else if (table_.size() > 0) {
+        // 选项都在ZDD之外的行中时（分量或残余问题）没有节点
+        setup_links_serial();
+    }
+    dp_mgr_ = make_unique<DpManager>(table_, num_var_, arena_.get());
+}
+
+template <typename Traits>
+void ZddWithLinks<Traits>::setup_links_serial() {
     // initialize counts
-    for (Node &node : table_) {
+    for (size_t i = 0; i < table_.size(); i++) {
+        auto node = table_[i];
         node.count_upper = 0;
         node.count_lo = 0;
         node.count_hi = 0;
     }
     // compute lower counts
     for (size_t i = 0; i < table_.size(); i++) {
-        Node &node = table_[i];
+        auto node = table_[i];
         if (node.lo == DD_ZERO_TERM) {
             node.count_lo = 0;
         } else if (node.lo == DD_ONE_TERM) {
@@ -853,8 +2061,8 @@ void ZddWithLinks::setup_dancing_links() {
 
     // compute upper counts
     table_[table_.size() - 1].count_upper = 1;
-    for (int i = table_.size() - 1; i >= 0; i--) {
-        Node &node = table_[i];
+    for (index_t i = table_.size() - 1; i >= 0; i--) {
+        auto node = table_[i];
         if (node.hi >= 0) {
             table_[node.hi].count_upper += node.count_upper;
         }
@@ -864,10 +2072,10 @@ void ZddWithLinks::setup_dancing_links() {
     }
     // set up up/down links
     for (size_t i = 0; i < table_.size(); i++) {
-        Node &node = table_[i];
+        auto node = table_[i];
         Header &header = header_[node.var];
         if (header.up >= 0) {
-            Node &prev = table_[header.up];
+            auto prev = table_[header.up];
             prev.down = i;
             node.up = header.up;
             node.down = -1;
@@ -888,13 +2096,13 @@ void ZddWithLinks::setup_dancing_links() {
     }
     // set parent node cells.
     for (size_t i = 0; i < table_.size(); i++) {
-        Node &node = table_[i];
+        auto node = table_[i];
 
         node.parents_head = i << 2UL | 2UL;
         node.parents_tail = i << 2UL | 2UL;
 
         if (node.hi >= 0) {
-            Node &child = table_[node.hi];
+            auto child = table_[node.hi];
             node.hi_prev = child.parents_tail;
             node.hi_next = node.hi << 2UL | 2UL;
             plink_set_next(child.parents_tail, i << 2UL | 1UL);
@@ -902,11 +2110,11 @@ void ZddWithLinks::setup_dancing_links() {
 
         } else {
             // these links will not be used;
-            node.hi_prev = UINT32_MAX;
-            node.hi_next = UINT32_MAX;
+            node.hi_prev = numeric_limits<plink_t>::max();
+            node.hi_next = numeric_limits<plink_t>::max();
         }
         if (node.lo >= 0) {
-            Node &child = table_[node.lo];
+            auto child = table_[node.lo];
             node.lo_prev = child.parents_tail;
             node.lo_next = node.lo << 2UL | 2UL;
             plink_set_next(child.parents_tail, i << 2UL);
@@ -914,11 +2122,156 @@ void ZddWithLinks::setup_dancing_links() {
             child.parents_tail = i << 2UL;
         } else {
             // these links will not be used;
-            node.lo_prev = UINT32_MAX;
-            node.lo_next = UINT32_MAX;
+            node.lo_prev = numeric_limits<plink_t>::max();
+            node.lo_next = numeric_limits<plink_t>::max();
         }
     }
-    dp_mgr_ = make_unique<DpManager>(table_, num_var_);
+}
+
+template <typename Traits>
+void ZddWithLinks<Traits>::setup_links_parallel() {
+    const index_t n = table_.size();
+    // 层：相同var的连续节点，子节点总在更前面的层中
+    vector<index_t> level_begin;
+    for (index_t i = 0; i < n; i++) {
+        if (i == 0 || table_[i].var != table_[i - 1].var) {
+            level_begin.push_back(i);
+        }
+    }
+    level_begin.push_back(n);
+    const size_t num_levels = level_begin.size() - 1;
+    auto level_size = [&](size_t l) -> size_t {
+        return level_begin[l + 1] - level_begin[l];
+    };
+
+    // compute lower counts, bottom-up level by level
+    auto lower_count = [&](index_t child) -> count_t {
+        if (child == DD_ONE_TERM) return 1;
+        if (child < 0) return 0;
+        return table_[child].count_lo + table_[child].count_hi;
+    };
+    for (size_t l = 0; l < num_levels; l++) {
+#pragma omp parallel for if (level_size(l) >= PARALLEL_SETUP_MIN_LEVEL)
+        for (index_t i = level_begin[l]; i < level_begin[l + 1]; i++) {
+            auto node = table_[i];
+            assert(node.hi < level_begin[l] && node.lo < level_begin[l]);
+            node.count_lo = lower_count(node.lo);
+            node.count_hi = lower_count(node.hi);
+        }
+    }
+
+    // group parent links by child: offsets[c] .. offsets[c + 1] are the
+    // parent links of c, filled from the back of each group
+    vector<plink_t> offsets(n + 1, 0);
+#pragma omp parallel for
+    for (index_t i = 0; i < n; i++) {
+        const auto node = table_[i];
+        if (node.hi >= 0) {
+#pragma omp atomic
+            offsets[node.hi]++;
+        }
+        if (node.lo >= 0) {
+#pragma omp atomic
+            offsets[node.lo]++;
+        }
+    }
+    partial_sum(offsets.begin(), offsets.end() - 1, offsets.begin());
+    offsets[n] = n > 0 ? offsets[n - 1] : 0;
+    vector<plink_t> entries(offsets[n]);
+    // 倒序填充，单线程时各组已按串行版本的顺序排列
+#pragma omp parallel for schedule(static)
+    for (index_t i = n - 1; i >= 0; i--) {
+        const auto node = table_[i];
+        plink_t pos;
+        if (node.lo >= 0) {
+#pragma omp atomic capture
+            pos = --offsets[node.lo];
+            entries[pos] = (plink_t)i << 2UL;
+        }
+        if (node.hi >= 0) {
+#pragma omp atomic capture
+            pos = --offsets[node.hi];
+            entries[pos] = (plink_t)i << 2UL | 1UL;
+        }
+    }
+
+    // link parent lists. the serial pass appends in the order of parent ids,
+    // the hi-edge before the lo-edge of the same parent.
+    auto serial_order = [](plink_t a, plink_t b) { return (a ^ 1UL) < (b ^ 1UL); };
+#pragma omp parallel for schedule(dynamic, 4096)
+    for (index_t c = 0; c < n; c++) {
+        plink_t *first = entries.data() + offsets[c];
+        plink_t *last = entries.data() + offsets[c + 1];
+        if (!is_sorted(first, last, serial_order)) {
+            sort(first, last, serial_order);
+        }
+        const plink_t self = (plink_t)c << 2UL | 2UL;
+        auto child = table_[c];
+        child.parents_head = first == last ? self : *first;
+        child.parents_tail = first == last ? self : *(last - 1);
+        for (plink_t *p = first; p < last; p++) {
+            plink_set_prev(*p, p == first ? self : *(p - 1));
+            plink_set_next(*p, p + 1 == last ? self : *(p + 1));
+        }
+        // these links will not be used;
+        auto node = table_[c];
+        if (node.hi < 0) {
+            node.hi_prev = numeric_limits<plink_t>::max();
+            node.hi_next = numeric_limits<plink_t>::max();
+        }
+        if (node.lo < 0) {
+            node.lo_prev = numeric_limits<plink_t>::max();
+            node.lo_next = numeric_limits<plink_t>::max();
+        }
+    }
+
+    // compute upper counts, top-down level by level, by summing the parents
+    for (size_t l = num_levels; l-- > 0;) {
+#pragma omp parallel for if (level_size(l) >= PARALLEL_SETUP_MIN_LEVEL)
+        for (index_t i = level_begin[l]; i < level_begin[l + 1]; i++) {
+            count_t count = i == n - 1 ? 1 : 0;
+            for (plink_t k = offsets[i]; k < offsets[i + 1]; k++) {
+                count += table_[plink_node_id(entries[k])].count_upper;
+            }
+            table_[i].count_upper = count;
+        }
+    }
+
+    // set up up/down links inside each level, and count options per level
+#pragma omp parallel for
+    for (index_t i = 0; i < n; i++) {
+        auto node = table_[i];
+        node.up = i > 0 && table_[i - 1].var == node.var ? i - 1 : -1;
+        node.down = i + 1 < n && table_[i + 1].var == node.var ? i + 1 : -1;
+    }
+    vector<count_t> level_counts(num_levels, 0);
+#pragma omp parallel for schedule(guided)
+    for (size_t l = 0; l < num_levels; l++) {
+        count_t counts = 0;
+        for (index_t i = level_begin[l]; i < level_begin[l + 1]; i++) {
+            const auto node = table_[i];
+            if (node.hi == DD_ONE_TERM) {
+                counts += node.count_upper;
+            } else if (node.hi >= 0) {
+                counts += node.count_upper * node.count_hi;
+            }
+        }
+        level_counts[l] = counts;
+    }
+    // join levels of the same var and set header cells
+    for (size_t l = 0; l < num_levels; l++) {
+        const index_t first = level_begin[l];
+        const index_t last = level_begin[l + 1] - 1;
+        Header &header = header_[table_[first].var];
+        if (header.up >= 0) {
+            table_[header.up].down = first;
+            table_[first].up = header.up;
+        } else {
+            header.down = first;
+        }
+        header.up = last;
+        header.count += level_counts[l];
+    }
 }
 /**
  * 计算上方向的选择路径
@@ -927,13 +2280,14 @@ void ZddWithLinks::setup_dancing_links() {
  * @param choice 存储选择路径的向量。
  * 计算从根节点到指定节点的选择路径。
  */
-void ZddWithLinks::compute_upper_choice(int32_t node_id, count_t up_id,
-                                        vector<uint16_t> &choice) noexcept {
+template <typename Traits>
+void ZddWithLinks<Traits>::compute_upper_choice(index_t node_id, count_t up_id,
+                                        vector<var_t> &choice) noexcept {
     choice.clear();
-    //    const int32_t root_id = table_.size() - 1;
+    //    const index_t root_id = table_.size() - 1;
 
     for (;;) {
-        const Node &node = table_[node_id];
+        const auto node = table_[node_id];
         assert(node.count_upper > 0);
         if (plink_is_term(node.parents_head)) {  // root node
             assert(node.count_upper > 0);
@@ -943,8 +2297,10 @@ void ZddWithLinks::compute_upper_choice(int32_t node_id, count_t up_id,
 
         plink_t plink = node.parents_head;
         for (;;) {
+            // 根节点被隐藏时其lo边不在父节点链表中，其余的路径从该节点开始
+            if (plink_is_term(plink)) return;
             const auto parent_id = plink_node_id(plink);
-            const Node &parent = table_[parent_id];
+            const auto parent = table_[parent_id];
             assert(parent.count_upper > 0);
             if (offset + parent.count_upper > up_id) {
                 up_id = up_id - offset;
@@ -969,16 +2325,17 @@ void ZddWithLinks::compute_upper_choice(int32_t node_id, count_t up_id,
  * @param choices_buf 存储选择路径的缓冲区。
  * 初始化从根节点到指定节点的选择路径。
  */
-void ZddWithLinks::compute_upper_initial_choice(
-    const int32_t start_id, vector<uint32_t> &visited,
-    vector<size_t> &diff_choices, vector<int32_t> &diff_choice_ids,
-    vector<uint16_t> &choices_buf) noexcept {
+template <typename Traits>
+void ZddWithLinks<Traits>::compute_upper_initial_choice(
+    const index_t start_id, vector<trace_t> &visited,
+    vector<size_t> &diff_choices, vector<index_t> &diff_choice_ids,
+    vector<var_t> &choices_buf) noexcept {
     visited.clear();
     diff_choices.clear();
     diff_choice_ids.clear();
-    int32_t node_id = start_id;
+    index_t node_id = start_id;
     for (;;) {
-        const Node &node = table_[node_id];
+        const auto node = table_[node_id];
         assert(node.count_upper > 0);
 
         if (plink_is_term(node.parents_head)) {
@@ -1033,10 +2390,11 @@ void ZddWithLinks::compute_upper_initial_choice(
  * @return 如果没有更多选择路径则返回 true，否则返回 false。
  * 计算从当前节点到下一个节点的选择路径。
  */
-bool ZddWithLinks::compute_upper_next_choice(vector<uint32_t> &visited,
+template <typename Traits>
+bool ZddWithLinks<Traits>::compute_upper_next_choice(vector<trace_t> &visited,
                                              vector<size_t> &diff_choices,
-                                             vector<int32_t> &diff_choice_ids,
-                                             vector<uint16_t> &choice_buf) {
+                                             vector<index_t> &diff_choice_ids,
+                                             vector<var_t> &choice_buf) {
     // uncover
     //    cerr << "update " << num_updates << endl;
     int var_prev = 100;
@@ -1048,7 +2406,7 @@ bool ZddWithLinks::compute_upper_next_choice(vector<uint32_t> &visited,
     while (!diff_choices.empty()) {
         size_t change_idx = *(diff_choices.rbegin());
         diff_choices.pop_back();
-        uint32_t child_id = *(diff_choice_ids.rbegin());
+        index_t child_id = *(diff_choice_ids.rbegin());
         diff_choice_ids.pop_back();
 
         trace2choice(visited.rbegin(),
@@ -1111,15 +2469,15 @@ bool ZddWithLinks::compute_upper_next_choice(vector<uint32_t> &visited,
     size_t prev_last_idx = *(diff_choices.rbegin());
     assert(prev_last_idx == visited.size() - 1);
 
-    int32_t node_id = visited[prev_last_idx] >> 1U;
+    index_t node_id = visited[prev_last_idx] >> 1U;
     for (;;) {
-        const Node &node = table_[node_id];
+        const auto node = table_[node_id];
         assert(node.count_upper > 0);
 
         if (plink_is_term(node.parents_head)) break;
 
         plink_t link = node.parents_head;
-        int32_t previous_id = node_id;
+        index_t previous_id = node_id;
         node_id = plink_node_id(link);
         assert(visited.empty() ||
                table_[*(visited.rbegin()) >> 1].var > table_[node_id].var);
@@ -1162,12 +2520,13 @@ bool ZddWithLinks::compute_upper_next_choice(vector<uint32_t> &visited,
  * @param choice 存储选择路径的向量。
  * 计算从根节点到指定节点的选择路径。
  */
-void ZddWithLinks::compute_lower_choice(int32_t node_id, count_t down_id,
-                                        vector<uint16_t> &choice) noexcept {
+template <typename Traits>
+void ZddWithLinks<Traits>::compute_lower_choice(index_t node_id, count_t down_id,
+                                        vector<var_t> &choice) noexcept {
     choice.clear();
 
     while (node_id >= 0) {
-        const Node &node = table_[node_id];
+        const auto node = table_[node_id];
 
         count_t offset = node.count_hi;
 
@@ -1188,15 +2547,16 @@ void ZddWithLinks::compute_lower_choice(int32_t node_id, count_t down_id,
  * @param choices_buf 存储选择路径的缓冲区。
  * 初始化从根节点到指定节点的选择路径。
  */
-void ZddWithLinks::compute_lower_initial_choice(const int32_t start_id,
-                                                vector<uint32_t> &visited,
+template <typename Traits>
+void ZddWithLinks<Traits>::compute_lower_initial_choice(const index_t start_id,
+                                                vector<trace_t> &visited,
                                                 vector<size_t> &diff_choices,
-                                                vector<uint16_t> &choices_buf) {
+                                                vector<var_t> &choices_buf) {
     visited.clear();
     diff_choices.clear();
-    int32_t node_id = start_id;
+    index_t node_id = start_id;
     while (node_id >= 0) {
-        const Node &node = table_[node_id];
+        const auto node = table_[node_id];
         if (node.count_hi > 0) {
             visited.push_back(node_id << 1U | 1U);
             if (node.count_lo > 0) {
@@ -1238,9 +2598,10 @@ void ZddWithLinks::compute_lower_initial_choice(const int32_t start_id,
  * @return 如果没有更多选择路径则返回 true，否则返回 false
  * 计算从当前节点到下一个节点的选择路径。
  */
-bool ZddWithLinks::compute_lower_next_choice(vector<uint32_t> &visited,
+template <typename Traits>
+bool ZddWithLinks<Traits>::compute_lower_next_choice(vector<trace_t> &visited,
                                              vector<size_t> &diff_choices,
-                                             vector<uint16_t> &choice_buf) {
+                                             vector<var_t> &choice_buf) {
     // uncover
     while (!diff_choices.empty()) {
         size_t change_idx = *(diff_choices.rbegin());
@@ -1274,11 +2635,11 @@ bool ZddWithLinks::compute_lower_next_choice(vector<uint32_t> &visited,
     }
 
     int prev_last_idx = *(diff_choices.rbegin());
-    int32_t node_id = visited[prev_last_idx] >> 1U;
+    index_t node_id = visited[prev_last_idx] >> 1U;
 
     node_id = table_[node_id].lo;
     while (node_id >= 0) {
-        const Node &node = table_[node_id];
+        const auto node = table_[node_id];
         if (node.count_hi > 0) {
             visited.push_back(node_id << 1U | 1U);
             if (node.count_lo > 0) {
@@ -1315,15 +2676,16 @@ bool ZddWithLinks::compute_lower_next_choice(vector<uint32_t> &visited,
  * @param node_id 要隐藏的节点 ID。
  * 隐藏指定的节点，更新父子链接。
  */
-void ZddWithLinks::hide_node(const int32_t node_id) {
-    Node &node = table_[node_id];
+template <typename Traits>
+void ZddWithLinks<Traits>::hide_node(const index_t node_id) {
+    auto node = table_[node_id];
     //    cerr << "hide " << node_id << endl;
 
     if (!plink_is_term(node.parents_head)) {
         for (plink_t plink = node.parents_head;;  // !plink_is_term(plink);
              plink = plink_get_next(plink)) {
-            int32_t parent_id = plink_node_id(plink);
-            Node &parent = table_[parent_id];
+            index_t parent_id = plink_node_id(plink);
+            auto parent = table_[parent_id];
             if (plink_is_hi(plink)) {
                 parent.hi = node.lo;
             } else {
@@ -1349,7 +2711,7 @@ void ZddWithLinks::hide_node(const int32_t node_id) {
     }
 
     if (nlo >= 0 && !plink_is_term(node.parents_head)) {
-        Node &lo_child = table_[nlo];
+        auto lo_child = table_[nlo];
         auto np_head = node.parents_head, np_tail = node.parents_tail;
         plink_set_prev(np_head, lo_child.parents_tail);
         plink_set_next(np_tail, (nlo << 2UL) | 2UL);
@@ -1362,12 +2724,13 @@ void ZddWithLinks::hide_node(const int32_t node_id) {
  * @param node_id 要取消隐藏的节点 ID。
  * 恢复指定节点的可见性，更新父子链接。
  */
-void ZddWithLinks::unhide_node(const int32_t node_id) {
-    Node &node = table_[node_id];
+template <typename Traits>
+void ZddWithLinks<Traits>::unhide_node(const index_t node_id) {
+    auto node = table_[node_id];
 
     auto nhi = node.hi, nlo = node.lo;
     if (nlo >= 0 && !plink_is_term(node.parents_head)) {
-        Node &lo_child = table_[nlo];
+        auto lo_child = table_[nlo];
 
         auto np_head = node.parents_head, np_tail = node.parents_tail;
         plink_t orig_lo_parent_head = plink_get_prev(np_head);
@@ -1395,8 +2758,8 @@ void ZddWithLinks::unhide_node(const int32_t node_id) {
     if (!plink_is_term(node.parents_tail)) {
         for (plink_t plink = node.parents_tail;;  // !plink_is_term(plink);
              plink = plink_get_prev(plink)) {
-            int32_t parent_id = plink_node_id(plink);
-            Node &parent = table_[parent_id];
+            index_t parent_id = plink_node_id(plink);
+            auto parent = table_[parent_id];
             if (plink_is_hi(plink)) {
                 parent.hi = node_id;
             } else {
@@ -1412,8 +2775,9 @@ void ZddWithLinks::unhide_node(const int32_t node_id) {
  * 隐藏cover_down类型的节点
  * @param node_id 要隐藏的节点 ID。
  */
-void ZddWithLinks::hide_node_cover_down(const int32_t node_id) {
-    Node &node = table_[node_id];
+template <typename Traits>
+void ZddWithLinks<Traits>::hide_node_cover_down(const index_t node_id) {
+    auto node = table_[node_id];
 
     if (node.hi >= 0) {
         auto hi_next = node.hi_next, hi_prev = node.hi_prev;
@@ -1422,8 +2786,9 @@ void ZddWithLinks::hide_node_cover_down(const int32_t node_id) {
     }
 }
 
-void ZddWithLinks::unhide_node_cover_down(const int32_t node_id) {
-    Node &node = table_[node_id];
+template <typename Traits>
+void ZddWithLinks<Traits>::unhide_node_cover_down(const index_t node_id) {
+    auto node = table_[node_id];
     if (node.hi >= 0) {
         auto hi_next = node.hi_next, hi_prev = node.hi_prev;
         plink_set_prev(hi_next, node_id << 2UL | 1UL);
@@ -1435,15 +2800,16 @@ void ZddWithLinks::unhide_node_cover_down(const int32_t node_id) {
  * @param node_id 要隐藏的节点 ID。
  * 隐藏cover_up类型的节点，更新父子链接。
  */
-void ZddWithLinks::hide_node_cover_up(const int32_t node_id) {
+template <typename Traits>
+void ZddWithLinks<Traits>::hide_node_cover_up(const index_t node_id) {
 
-    Node &node = table_[node_id];
+    auto node = table_[node_id];
 
     if (!plink_is_term(node.parents_head)) {
         for (plink_t plink = node.parents_head;;  //! plink_is_term(plink);
              plink = plink_get_next(plink)) {
-            int32_t parent_id = plink_node_id(plink);
-            Node &parent = table_[parent_id];
+            index_t parent_id = plink_node_id(plink);
+            auto parent = table_[parent_id];
             if (plink_is_hi(plink)) {
                 parent.hi = node.lo;
             } else {
@@ -1460,7 +2826,7 @@ void ZddWithLinks::hide_node_cover_up(const int32_t node_id) {
     }
 
     if (node.lo >= 0 && !plink_is_term(node.parents_head)) {
-        Node &lo_child = table_[node.lo];
+        auto lo_child = table_[node.lo];
         auto np_head = node.parents_head, np_tail = node.parents_tail;
         plink_set_prev(np_head, lo_child.parents_tail);
         plink_set_next(np_tail, (node.lo << 2UL) | 2UL);
@@ -1473,11 +2839,12 @@ void ZddWithLinks::hide_node_cover_up(const int32_t node_id) {
  * @param node_id 要取消隐藏的节点 ID。
  * 恢复cover_up类型节点的可见性，更新父子链接。
  */
-void ZddWithLinks::unhide_node_cover_up(const int32_t node_id) {
-    Node &node = table_[node_id];
+template <typename Traits>
+void ZddWithLinks<Traits>::unhide_node_cover_up(const index_t node_id) {
+    auto node = table_[node_id];
 
     if (node.lo >= 0 && !plink_is_term(node.parents_head)) {
-        Node &lo_child = table_[node.lo];
+        auto lo_child = table_[node.lo];
 
         auto np_head = node.parents_head, np_tail = node.parents_tail;
         plink_t orig_lo_parent_head = plink_get_prev(np_head);
@@ -1499,8 +2866,8 @@ void ZddWithLinks::unhide_node_cover_up(const int32_t node_id) {
     if (!plink_is_term(node.parents_head)) {
         for (plink_t plink = node.parents_tail;;  //! plink_is_term(plink);
              plink = plink_get_prev(plink)) {
-            int32_t parent_id = plink_node_id(plink);
-            Node &parent = table_[parent_id];
+            index_t parent_id = plink_node_id(plink);
+            auto parent = table_[parent_id];
             if (plink_is_hi(plink)) {
                 parent.hi = node_id;
             } else {
@@ -1515,8 +2882,9 @@ void ZddWithLinks::unhide_node_cover_up(const int32_t node_id) {
  * @param node_id 要隐藏的节点 ID。
  * 隐藏upperzero类型的节点，更新父子链接。
  */
-void ZddWithLinks::hide_node_upperzero(const int32_t node_id) {
-    Node &node = table_[node_id];
+template <typename Traits>
+void ZddWithLinks<Traits>::hide_node_upperzero(const index_t node_id) {
+    auto node = table_[node_id];
     assert(node.count_hi > 0);
     auto nhi = node.hi, nlo = node.lo;
     if (nhi >= 0) {
@@ -1536,8 +2904,9 @@ void ZddWithLinks::hide_node_upperzero(const int32_t node_id) {
  * @param node_id 要取消隐藏的节点 ID。
  * 恢复upperzero类型节点的可见性，更新父子链接。
  */
-void ZddWithLinks::unhide_node_upperzero(const int32_t node_id) {
-    Node &node = table_[node_id];
+template <typename Traits>
+void ZddWithLinks<Traits>::unhide_node_upperzero(const index_t node_id) {
+    auto node = table_[node_id];
     if (node.lo >= 0) {
         auto lo_next = node.lo_next, lo_prev = node.lo_prev;
         plink_set_prev(lo_next, node_id << 2UL);
@@ -1557,13 +2926,14 @@ void ZddWithLinks::unhide_node_upperzero(const int32_t node_id) {
  * @param node_id 要隐藏的节点 ID。
  * 隐藏lowerzero类型的节点，更新父子链接。
  */
-void ZddWithLinks::hide_node_lowerzero(const int32_t node_id) {
-    Node &node = table_[node_id];
+template <typename Traits>
+void ZddWithLinks<Traits>::hide_node_lowerzero(const index_t node_id) {
+    auto node = table_[node_id];
     if (!plink_is_term(node.parents_head)) {
         for (plink_t plink = node.parents_head;;  // !plink_is_term(plink);
              plink = plink_get_next(plink)) {
-            int32_t parent_id = plink_node_id(plink);
-            Node &parent = table_[parent_id];
+            index_t parent_id = plink_node_id(plink);
+            auto parent = table_[parent_id];
             if (plink_is_hi(plink)) {
                 parent.hi = node.lo;
             } else {
@@ -1582,7 +2952,7 @@ void ZddWithLinks::hide_node_lowerzero(const int32_t node_id) {
     }
 
     if (node.lo >= 0 && !plink_is_term(node.parents_head)) {
-        Node &lo_child = table_[node.lo];
+        auto lo_child = table_[node.lo];
         auto np_head = node.parents_head, np_tail = node.parents_tail;
         plink_set_prev(np_head, lo_child.parents_tail);
         plink_set_next(np_tail,
@@ -1596,11 +2966,12 @@ void ZddWithLinks::hide_node_lowerzero(const int32_t node_id) {
  * @param node_id 要取消隐藏的节点 ID。
  * 恢复lowerzero类型节点的可见性，更新父子链接。
  */
-void ZddWithLinks::unhide_node_lowerzero(const int32_t node_id) {
-    Node &node = table_[node_id];
+template <typename Traits>
+void ZddWithLinks<Traits>::unhide_node_lowerzero(const index_t node_id) {
+    auto node = table_[node_id];
 
     if (node.lo >= 0 && !plink_is_term(node.parents_head)) {
-        Node &lo_child = table_[node.lo];
+        auto lo_child = table_[node.lo];
 
         auto np_head = node.parents_head, np_tail = node.parents_tail;
         plink_t orig_lo_parent_head = plink_get_prev(np_head);
@@ -1620,8 +2991,8 @@ void ZddWithLinks::unhide_node_lowerzero(const int32_t node_id) {
     if (plink_is_term(node.parents_head)) return;
     for (plink_t plink = node.parents_tail;;  // !plink_is_term(plink);
          plink = plink_get_prev(plink)) {
-        int32_t parent_id = plink_node_id(plink);
-        Node &parent = table_[parent_id];
+        index_t parent_id = plink_node_id(plink);
+        auto parent = table_[parent_id];
         if (plink_is_hi(plink)) {
             parent.hi = node_id;
         } else {
@@ -1637,145 +3008,164 @@ void ZddWithLinks::unhide_node_lowerzero(const int32_t node_id) {
  * @return 如果结构有效则返回 false，否则返回 true。
  * 检查DanceDD结构的完整性和一致性。
  */
-bool ZddWithLinks::sanity() const {
+template <typename Traits>
+bool ZddWithLinks<Traits>::sanity() const {
     int pos, prev;
 
     bool has_error = false;
 
-    for (pos = header_[0].right, prev = 0;;
-         prev = pos, pos = header_[pos].right) {
-        if (header_[pos].left != prev) {
-            cerr << "Bad prev field at " << pos << endl;
-            has_error = true;
-        }
-        if (pos == 0) break;
-
-        uint64_t counter = 0ULL;
-
-        int npos = header_[pos].down;
-        int nprev = -1;
-
-        for (;; nprev = npos, npos = table_[npos].down) {
-            if (npos >= 0 && table_[npos].up != nprev) {
-                cerr << "Bad up filed at node " << npos << endl;
-                has_error = true;
-            } else if (npos < 0 && header_[pos].up != nprev) {
-                cerr << "Bad up filed at header " << pos << endl;
+    // 主列和次要列的链表
+    for (const int head : {0, num_var_ + 1}) {
+        for (pos = header_[head].right, prev = head;;
+             prev = pos, pos = header_[pos].right) {
+            if (header_[pos].left != prev) {
+                cerr << "Bad prev field at " << pos << endl;
                 has_error = true;
             }
-            if (npos < 0) break;
+            if (pos == head) break;
 
-            const Node &node = table_[npos];
-            if (node.count_upper == 0 || node.count_hi == 0) {
-                cerr << "Bad count at node " << npos << endl;
-                has_error = true;
-            }
-            counter += node.count_upper * node.count_hi;
+            count_t counter = 0;
 
-            // check parent links
-            plink_t prev_link = npos << 2 | 2LU;
-            for (plink_t plink = node.parents_head;;
-                 prev_link = plink, plink = plink_get_next(plink)) {
-                const auto &parent = table_[plink_node_id(plink)];
-                plink_t back_link;
-                if (plink_is_term(plink)) {
-                    back_link = parent.parents_tail;
-                } else if (plink_is_hi(plink)) {
-                    back_link = parent.hi_prev;
-                } else {
-                    back_link = parent.lo_prev;
-                }
+            index_t npos = header_[pos].down;
+            index_t nprev = -1;
 
-                if (back_link != prev_link) {
-                    cerr << "Bad parent links at " << npos << endl;
+            for (;; nprev = npos, npos = table_[npos].down) {
+                if (npos >= 0 && table_[npos].up != nprev) {
+                    cerr << "Bad up filed at node " << npos << endl;
+                    has_error = true;
+                } else if (npos < 0 && header_[pos].up != nprev) {
+                    cerr << "Bad up filed at header " << pos << endl;
                     has_error = true;
                 }
+                if (npos < 0) break;
 
-                if (plink == ((npos << 2LU) | 2LU)) {
-                    break;
-                }
-                assert(!plink_is_term(plink));
-                if (plink_is_hi(plink) && parent.hi != npos) {
-                    cerr << "Bad parent hi at " << plink_node_id(plink) << endl;
-                    has_error = true;
-                } else if (!plink_is_hi(plink) && parent.lo != npos) {
-                    cerr << "Bad parent lo at " << plink_node_id(plink)
-                         << " node:" << npos << endl;
+                const auto node = table_[npos];
+                if (node.count_upper == 0 || node.count_hi == 0) {
+                    cerr << "Bad count at node " << npos << endl;
                     has_error = true;
                 }
-            }
+                counter += node.count_upper * node.count_hi;
+
+                // check parent links
+                plink_t prev_link = (plink_t)npos << 2 | 2LU;
+                for (plink_t plink = node.parents_head;;
+                     prev_link = plink, plink = plink_get_next(plink)) {
+                    const auto parent = table_[plink_node_id(plink)];
+                    plink_t back_link;
+                    if (plink_is_term(plink)) {
+                        back_link = parent.parents_tail;
+                    } else if (plink_is_hi(plink)) {
+                        back_link = parent.hi_prev;
+                    } else {
+                        back_link = parent.lo_prev;
+                    }
 
-            // check child links
-            if (node.lo >= 0) {
-                const auto &child = table_[node.lo];
-                if (node.var >= child.var) {
-                    has_error = true;
-                    cerr << "Child node " << node.lo << " has larger var than "
-                         << npos << endl;
+                    if (back_link != prev_link) {
+                        cerr << "Bad parent links at " << npos << endl;
+                        has_error = true;
+                    }
+
+                    if (plink == ((npos << 2LU) | 2LU)) {
+                        break;
+                    }
+                    assert(!plink_is_term(plink));
+                    if (plink_is_hi(plink) && parent.hi != npos) {
+                        cerr << "Bad parent hi at " << plink_node_id(plink)
+                             << endl;
+                        has_error = true;
+                    } else if (!plink_is_hi(plink) && parent.lo != npos) {
+                        cerr << "Bad parent lo at " << plink_node_id(plink)
+                             << " node:" << npos << endl;
+                        has_error = true;
+                    }
                 }
-                bool has_parent_link = false;
-                if (!plink_is_term(child.parents_head)) {
-                    for (plink_t plink = child.parents_head;
-                         ;  // !plink_is_term(plink);
-                         plink = plink_get_next(plink)) {
-                        if (!plink_is_hi(plink) &&
-                            plink_node_id(plink) == npos) {
-                            has_parent_link = true;
+
+                // check child links
+                if (node.lo >= 0) {
+                    const auto child = table_[node.lo];
+                    if (node.var >= child.var) {
+                        has_error = true;
+                        cerr << "Child node " << node.lo
+                             << " has larger var than " << npos << endl;
+                    }
+                    bool has_parent_link = false;
+                    if (!plink_is_term(child.parents_head)) {
+                        for (plink_t plink = child.parents_head;
+                             ;  // !plink_is_term(plink);
+                             plink = plink_get_next(plink)) {
+                            if (!plink_is_hi(plink) &&
+                                plink_node_id(plink) == npos) {
+                                has_parent_link = true;
+                            }
+                            if (plink == child.parents_tail) break;
                         }
-                        if (plink == child.parents_tail) break;
+                    }
+                    if (!has_parent_link) {
+                        cerr << "Child node " << node.lo
+                             << " does not have parent link to " << npos
+                             << endl;
+                        has_error = true;
                     }
                 }
-                if (!has_parent_link) {
-                    cerr << "Child node " << node.lo
-                         << " does not have parent link to " << npos << endl;
-                    has_error = true;
-                }
-            }
 
-            if (node.hi >= 0) {
-                const auto &child = table_[node.hi];
-                bool has_parent_link = false;
-                if (node.var >= child.var) {
-                    has_error = true;
-                    cerr << "Child node " << node.hi << " has larger var than "
-                         << npos << endl;
-                }
-                if (!plink_is_term(child.parents_head)) {
-                    for (plink_t plink = child.parents_head;
-                         ;  //! plink_is_term(plink);
-                         plink = plink_get_next(plink)) {
-                        if (plink_is_hi(plink) &&
-                            plink_node_id(plink) == npos) {
-                            has_parent_link = true;
+                if (node.hi >= 0) {
+                    const auto child = table_[node.hi];
+                    bool has_parent_link = false;
+                    if (node.var >= child.var) {
+                        has_error = true;
+                        cerr << "Child node " << node.hi
+                             << " has larger var than " << npos << endl;
+                    }
+                    if (!plink_is_term(child.parents_head)) {
+                        for (plink_t plink = child.parents_head;
+                             ;  //! plink_is_term(plink);
+                             plink = plink_get_next(plink)) {
+                            if (plink_is_hi(plink) &&
+                                plink_node_id(plink) == npos) {
+                                has_parent_link = true;
+                            }
+                            if (plink == child.parents_tail) break;
                         }
-                        if (plink == child.parents_tail) break;
                     }
-                }
-                if (!has_parent_link) {
-                    cerr << "Child node " << node.hi
-                         << " does not have parent link to " << npos << endl;
-                    has_error = true;
+                    if (!has_parent_link) {
+                        cerr << "Child node " << node.hi
+                             << " does not have parent link to " << npos
+                             << endl;
+                        has_error = true;
+                    }
                 }
             }
-        }
 
-        if (counter != header_[pos].count) {
-            cerr << "Count incosistent at header " << pos << endl;
-            has_error = true;
+            if (!side_cells_.empty()) {
+                for (index_t cell = side_cells_[pos].down; cell != pos;
+                     cell = side_cells_[cell].down) {
+                    counter += 1;
+                }
+            }
+            if (counter != header_[pos].count) {
+                cerr << "Count incosistent at header " << pos << endl;
+                has_error = true;
+            }
         }
     }
 
     // check model count
 
-    if (header_[0].right == 0) return has_error;
-
+    // 根节点在未覆盖的列中最小的列
     int root_var = header_[0].right;
-    int root_nid = header_[root_var].down;
+    const int secondary_var = header_[num_var_ + 1].right;
+    if (secondary_var != num_var_ + 1 &&
+        (root_var == 0 || secondary_var < root_var)) {
+        root_var = secondary_var;
+    }
+    if (root_var == 0) return has_error;
+
+    index_t root_nid = header_[root_var].down;
     if (root_nid == -1) return has_error;
 
     {
-        unordered_set<int32_t> reachable;
-        stack<int32_t> stk;
+        unordered_set<index_t> reachable;
+        stack<index_t> stk;
         reachable.insert(root_nid);
         stk.push(root_nid);
 
@@ -1783,7 +3173,7 @@ bool ZddWithLinks::sanity() const {
             const auto nid = stk.top();
             stk.pop();
 
-            const auto &nde = table_[nid];
+            const auto nde = table_[nid];
             if (nde.lo >= 0 && reachable.find(nde.lo) == reachable.end()) {
                 reachable.insert(nde.lo);
                 stk.push(nde.lo);
@@ -1794,10 +3184,10 @@ bool ZddWithLinks::sanity() const {
             }
         }
 
-        vector<int32_t> sorted_nodes(reachable.begin(), reachable.end());
+        vector<index_t> sorted_nodes(reachable.begin(), reachable.end());
 
         std::sort(sorted_nodes.begin(), sorted_nodes.end(),
-                  std::greater<int32_t>());
+                  std::greater<index_t>());
 
         vector<count_t> dp_upper(table_.size(), 0UL);
         vector<count_t> dp_hi(table_.size(), 0ULL);
@@ -1805,12 +3195,13 @@ bool ZddWithLinks::sanity() const {
 
         dp_upper[sorted_nodes[0]] = 1;
 
-        for (int i = 0; i < sorted_nodes.size(); i++) {
+        for (size_t i = 0; i < sorted_nodes.size(); i++) {
             const auto nid = sorted_nodes[i];
-            const Node &n = table_[nid];
+            const auto n = table_[nid];
             if (n.count_upper != dp_upper[nid]) {
                 cerr << "Bad count upper at node " << nid << " "
-                     << n.count_upper << ", " << dp_upper[nid] << endl;
+                     << count_to_string(n.count_upper) << ", "
+                     << count_to_string(dp_upper[nid]) << endl;
                 has_error = true;
             }
             if (n.lo >= 0) {
@@ -1821,17 +3212,18 @@ bool ZddWithLinks::sanity() const {
             }
         }
 
-        for (int i = sorted_nodes.size() - 1; i >= 0; i--) {
+        for (index_t i = sorted_nodes.size() - 1; i >= 0; i--) {
             const auto nid = sorted_nodes[i];
-            const Node &n = table_[nid];
+            const auto n = table_[nid];
             if (n.hi == DD_ONE_TERM) {
                 dp_hi[nid] = 1;
             } else if (n.hi >= 0) {
                 dp_hi[nid] = dp_hi[n.hi] + dp_lo[n.hi];
             }
             if (dp_hi[nid] != n.count_hi) {
-                cerr << "Bad count hi at node " << nid << " " << n.count_hi
-                     << ", " << dp_hi[nid] << endl;
+                cerr << "Bad count hi at node " << nid << " "
+                     << count_to_string(n.count_hi) << ", "
+                     << count_to_string(dp_hi[nid]) << endl;
                 has_error = true;
             }
 
@@ -1841,8 +3233,9 @@ bool ZddWithLinks::sanity() const {
                 dp_lo[nid] = dp_hi[n.lo] + dp_lo[n.lo];
             }
             if (dp_lo[nid] != n.count_lo) {
-                cerr << "Bad count lo at node " << nid << " " << n.count_lo
-                     << ", " << dp_lo[nid] << endl;
+                cerr << "Bad count lo at node " << nid << " "
+                     << count_to_string(n.count_lo) << ", "
+                     << count_to_string(dp_lo[nid]) << endl;
                 has_error = true;
             }
         }
@@ -1850,3 +3243,16 @@ bool ZddWithLinks::sanity() const {
 
     return has_error;
 }
+
+template class ZddWithLinks<ZddTraits<uint32_t, int32_t, uint16_t>>;
+template class ZddWithLinks<ZddTraits<uint32_t, int32_t, uint32_t>>;
+template class ZddWithLinks<ZddTraits<uint32_t, int64_t, uint16_t>>;
+template class ZddWithLinks<ZddTraits<uint32_t, int64_t, uint32_t>>;
+template class ZddWithLinks<ZddTraits<uint64_t, int32_t, uint16_t>>;
+template class ZddWithLinks<ZddTraits<uint64_t, int32_t, uint32_t>>;
+template class ZddWithLinks<ZddTraits<uint64_t, int64_t, uint16_t>>;
+template class ZddWithLinks<ZddTraits<uint64_t, int64_t, uint32_t>>;
+template class ZddWithLinks<ZddTraits<count128_t, int32_t, uint16_t>>;
+template class ZddWithLinks<ZddTraits<count128_t, int32_t, uint32_t>>;
+template class ZddWithLinks<ZddTraits<count128_t, int64_t, uint16_t>>;
+template class ZddWithLinks<ZddTraits<count128_t, int64_t, uint32_t>>;
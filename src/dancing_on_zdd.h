@@ -9,19 +9,27 @@
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <queue>
 #include <sstream>
 #include <stack>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
+#include "arena.h"
+#include "component_cache.h"
+
 #include "hidden_node_stack.h"
 using namespace std;
+template <typename Traits>
 class DpManager;
-class HiddenNodeStack;
+struct RawZdd;
+struct SideRows;
+struct ColumnBounds;
 
 /**
  * constants
@@ -34,21 +42,77 @@ constexpr int DD_ZERO_TERM =
          // 代表 ZDD 结构中的终端节点（1-terminal）
 constexpr int MAX_DEPTH = 1000;  // maximum depth of the search tree.
 using nstack_t = std::stack<int32_t>;// 定义节点栈类型
-using count_t = uint32_t;// 计数类型
+using count128_t = unsigned __int128;  // 128位计数类型
 
 /**
- * type of parent links
+ * type of parent links (ZddTraits::plink_t)
  * lower 2 bits are used for flags, remaining bits are used for showing parent
  * nodes.
  * 父链接类型
  * 低2位用于标志，其余位用于存储父节点信息
  */
-using plink_t = uint32_t;  //
 constexpr uint32_t PLINK_IS_TERMINAL = 2LU; // 终端节点标志
 constexpr uint32_t PLINK_IS_HI = 1LU;       // HI（1-分支）链接标志
 constexpr uint32_t PLINK_ADDR_OFFSET = 2LU; // 地址偏移量
 // PLINK_ADDR_OFFSET 定义了父链接地址的位移量，用于确保在节点引用中的正确定位
 
+/**
+ * integer widths of a DanceDD instance.
+ * @tparam Count type of path counts (count_upper, count_hi, count_lo and
+ * header counts). It must hold the number of options of the ZDD.
+ * @tparam Index signed type of node cell ids. Parent links are the unsigned
+ * type of the same width, so at most max_nodes node cells can be addressed.
+ * @tparam Var unsigned type of variables (columns). Header links use the signed
+ * type of the same width, so at most max_vars columns can be represented.
+ * DanceDD实例的整数位宽。
+ * Count为路径计数的类型，必须能够保存ZDD的选项数量。
+ * Index为节点单元id的有符号类型，父链接使用同宽度的无符号类型。
+ * Var为变量（列）的无符号类型，列头链接使用同宽度的有符号类型。
+ */
+template <typename Count, typename Index = int32_t, typename Var = uint16_t>
+struct ZddTraits {
+    using count_t = Count;
+    using index_t = Index;
+    using plink_t = std::make_unsigned_t<Index>;
+    using var_t = Var;
+    using col_t = std::make_signed_t<Var>;
+
+    // number of node cells addressable by parent links
+    static constexpr uint64_t max_nodes =
+        std::numeric_limits<plink_t>::max() >> PLINK_ADDR_OFFSET;
+    // number of columns addressable by header links; the cell after the last
+    // column is the head of the list of secondary columns
+    static constexpr uint64_t max_vars = std::numeric_limits<col_t>::max() - 1;
+};
+
+/**
+ * @brief 将计数转换为十进制字符串，用于输出128位计数。
+ */
+template <typename Count>
+inline std::string count_to_string(Count count) {
+    if (count == 0) return "0";
+    std::string str;
+    for (; count > 0; count /= 10) {
+        str.push_back('0' + (int)(count % 10));
+    }
+    return std::string(str.rbegin(), str.rend());
+}
+
+/**
+ * assumptions of a query on a loaded instance (see
+ * ZddWithLinks::count_with_assumptions).
+ * @attr columns: columns regarded as covered outside the options.
+ * @attr forced: options contained in every solution, in ascending columns.
+ * @attr forbidden: options contained in no solution, in ascending columns.
+ * 对已加载的实例的查询的假设：视为已在选项之外覆盖的列、解必须包含的选项和解不能包含的选项。
+ */
+struct Assumptions {
+    std::vector<uint32_t> columns;
+    std::vector<std::vector<uint32_t>> forced;
+    std::vector<std::vector<uint32_t>> forbidden;
+};
+
+
 /**
  * Node cell
  * @attr var: corresponding variable
@@ -83,15 +147,21 @@ constexpr uint32_t PLINK_ADDR_OFFSET = 2LU; // 地址偏移量
  * @attr count_hi：从hi-child到TOP-terminal的路由数。
  * @attr count_lo：从lo子节点到TOP-terminal的路由数。
  */
+template <typename Traits>
 struct Node {
    public:
+    using count_t = typename Traits::count_t;
+    using index_t = typename Traits::index_t;
+    using plink_t = typename Traits::plink_t;
+    using var_t = typename Traits::var_t;
+
    /**
     * @brief 构造函数，初始化节点。
     * @param var 变量编号。
     * @param hi 1-分支的子节点 ID。
     * @param lo 0-分支的子节点 ID。
     */
-    Node(uint16_t var, int32_t hi, int32_t lo)
+    Node(var_t var, index_t hi, index_t lo)
         : hi(hi),
           lo(lo),
           up(-1),
@@ -135,10 +205,10 @@ struct Node {
     }
     // 判断两个node是否不相同
     bool operator!=(const Node &obj) const { return !(*this == obj); }
-    int32_t hi;
-    int32_t lo;
-    int32_t up;
-    int32_t down;
+    index_t hi;
+    index_t lo;
+    index_t up;
+    index_t down;
     plink_t parents_head;
     plink_t parents_tail;
     plink_t hi_next;
@@ -148,8 +218,8 @@ struct Node {
     count_t count_hi;
     count_t count_lo;
     count_t count_upper;
-    uint16_t var;
-    uint16_t padding;
+    var_t var;
+    var_t padding;
 };
 
 /**
@@ -168,9 +238,16 @@ struct Node {
  * @attr var：对应的变量
  * @attr count：拥有该变量的选项数
  */
+template <typename Traits>
 struct Header {
    public:
-    Header(int16_t left, int16_t right, int32_t down, int32_t up, uint16_t var,
+    using count_t = typename Traits::count_t;
+    using index_t = typename Traits::index_t;
+    using var_t = typename Traits::var_t;
+    using col_t = typename Traits::col_t;
+
+    Header() = default;
+    Header(col_t left, col_t right, index_t down, index_t up, var_t var,
            count_t count)
         : left(left),
           right(right),
@@ -188,30 +265,230 @@ struct Header {
 
     bool operator!=(const Header &o) const { return !((*this) == o); }
 
-    int16_t left;
-    int16_t right;
-    uint16_t var;
-    uint16_t padding1;  // dummy value
-    int32_t down;
-    int32_t up;
+    col_t left;
+    col_t right;
+    var_t var;
+    var_t padding1;  // dummy value
+    index_t down;
+    index_t up;
     count_t count;
     int32_t padding2;
 };
 
+/**
+ * Storage of node cells split by access pattern (hot/cold layout).
+ * @attr hot_: fields read by the downward sweeps of batch_cover/batch_uncover
+ * and by the enumerators (hi, lo, down, counts and var).
+ * @attr links_: parent links, read by the upward sweeps.
+ * @attr up_: only used when a node cell is hidden or unhidden.
+ * operator[] returns a proxy whose members refer to the fields of one node
+ * cell, so that node.count_upper etc. are written as with a vector of Node.
+ * layout_bench compares this table with a vector of Node on the same sweeps.
+ * Without cache-miss counters (perf_event_paranoid=2) only its times were
+ * measured, and the split was 1.1-1.2x slower than Node on 2^20-2^22 random
+ * cells and about 2x slower in cache, as each access touches two arrays.
+ * layout_bench比较本表与Node的数组；拆分后的访问需读写两个数组，
+ * 在无法读取缓存未命中数的环境中只比较了时间，拆分没有更快。
+ * 按访问模式拆分存储的节点单元表。
+ * hot_：batch_cover/batch_uncover向下扫描和枚举时读取的字段。
+ * links_：向上扫描时读取的父链接。
+ * up_：只在隐藏和恢复节点时使用。
+ * operator[] 返回引用各字段的代理对象，使用方式与Node的数组相同。
+ */
+template <typename Traits>
+class NodeTable {
+   public:
+    using count_t = typename Traits::count_t;
+    using index_t = typename Traits::index_t;
+    using plink_t = typename Traits::plink_t;
+    using var_t = typename Traits::var_t;
+
+    struct NodeHot {
+        index_t hi;
+        index_t lo;
+        index_t down;
+        count_t count_hi;
+        count_t count_lo;
+        count_t count_upper;
+        var_t var;
+    };
+
+    struct NodeLinks {
+        plink_t parents_head;
+        plink_t parents_tail;
+        plink_t hi_next;
+        plink_t hi_prev;
+        plink_t lo_next;
+        plink_t lo_prev;
+    };
+
+    /**
+     * proxy of a node cell. Const selects read-only access.
+     */
+    template <bool Const>
+    struct Ref {
+        template <typename T>
+        using ref_t = std::conditional_t<Const, const T &, T &>;
+
+        Ref(ref_t<NodeHot> hot, ref_t<NodeLinks> links, ref_t<index_t> up)
+            : hi(hot.hi),
+              lo(hot.lo),
+              up(up),
+              down(hot.down),
+              parents_head(links.parents_head),
+              parents_tail(links.parents_tail),
+              hi_next(links.hi_next),
+              hi_prev(links.hi_prev),
+              lo_next(links.lo_next),
+              lo_prev(links.lo_prev),
+              count_hi(hot.count_hi),
+              count_lo(hot.count_lo),
+              count_upper(hot.count_upper),
+              var(hot.var) {}
+
+        ref_t<index_t> hi;
+        ref_t<index_t> lo;
+        ref_t<index_t> up;
+        ref_t<index_t> down;
+        ref_t<plink_t> parents_head;
+        ref_t<plink_t> parents_tail;
+        ref_t<plink_t> hi_next;
+        ref_t<plink_t> hi_prev;
+        ref_t<plink_t> lo_next;
+        ref_t<plink_t> lo_prev;
+        ref_t<count_t> count_hi;
+        ref_t<count_t> count_lo;
+        ref_t<count_t> count_upper;
+        const var_t &var;
+    };
+
+    Ref<false> operator[](size_t id) {
+        return Ref<false>(hot_[id], links_[id], up_[id]);
+    }
+    Ref<true> operator[](size_t id) const {
+        return Ref<true>(hot_[id], links_[id], up_[id]);
+    }
+
+    /**
+     * @brief 以Node的形式复制一个节点单元，用于比较和调试。
+     */
+    Node<Traits> node_at(size_t id) const {
+        const auto ref = (*this)[id];
+        Node<Traits> node(ref.var, ref.hi, ref.lo);
+        node.up = ref.up, node.down = ref.down;
+        node.parents_head = ref.parents_head;
+        node.parents_tail = ref.parents_tail;
+        node.hi_next = ref.hi_next, node.hi_prev = ref.hi_prev;
+        node.lo_next = ref.lo_next, node.lo_prev = ref.lo_prev;
+        node.count_hi = ref.count_hi, node.count_lo = ref.count_lo;
+        node.count_upper = ref.count_upper;
+        return node;
+    }
+
+    void emplace_back(var_t var, index_t hi, index_t lo) {
+        hot_.push_back({hi, lo, -1, 0, 0, 0, var});
+        links_.push_back({0, 0, 0, 0, 0, 0});
+        up_.push_back(-1);
+    }
+
+    /**
+     * @brief 预先分配n个节点单元的空间。
+     * @param arena 分配各数组的Arena，nullptr 时使用堆。
+     */
+    void reserve(size_t n, Arena *arena = nullptr) {
+        if (arena) {
+            hot_ = arena_vector<NodeHot>(ArenaAllocator<NodeHot>(arena));
+            links_ = arena_vector<NodeLinks>(ArenaAllocator<NodeLinks>(arena));
+            up_ = arena_vector<index_t>(ArenaAllocator<index_t>(arena));
+        }
+        hot_.reserve(n);
+        links_.reserve(n);
+        up_.reserve(n);
+    }
+
+    /**
+     * @brief 计算n个节点单元的各数组在Arena中占用的字节数。
+     */
+    static size_t arena_size(size_t n) {
+        return arena_bytes<NodeHot>(n) + arena_bytes<NodeLinks>(n) +
+               arena_bytes<index_t>(n);
+    }
+
+    /**
+     * @brief 各数组实际占用的字节数（按容量计算）。
+     * @return (名称, 字节数) 的列表。
+     */
+    std::vector<std::pair<const char *, size_t>> footprint() const {
+        return {
+            {"node hot fields", hot_.capacity() * sizeof(NodeHot)},
+            {"node parent links", links_.capacity() * sizeof(NodeLinks)},
+            {"node up links", up_.capacity() * sizeof(index_t)},
+        };
+    }
+
+    size_t size() const { return hot_.size(); }
+
+    /**
+     * @brief 按快照中的顺序对各数组调用 f(data, bytes)。
+     */
+    template <typename F>
+    void for_each_snapshot_array(F &&f) const {
+        f(hot_.data(), hot_.size() * sizeof(NodeHot));
+        f(links_.data(), links_.size() * sizeof(NodeLinks));
+        f(up_.data(), up_.size() * sizeof(index_t));
+    }
+
+    /**
+     * @brief 使用快照映射中保存的n个节点单元，不进行复制。
+     * @param arena 快照文件的Arena，按 for_each_snapshot_array 的顺序分配。
+     */
+    void adopt(size_t n, Arena *arena) {
+        hot_ = arena_vector<NodeHot>(n, ArenaAllocator<NodeHot>(arena));
+        links_ = arena_vector<NodeLinks>(n, ArenaAllocator<NodeLinks>(arena));
+        up_ = arena_vector<index_t>(n, ArenaAllocator<index_t>(arena));
+    }
+
+    // bytes used by one node cell over all arrays
+    static constexpr size_t bytes_per_node =
+        sizeof(NodeHot) + sizeof(NodeLinks) + sizeof(index_t);
+
+   private:
+    arena_vector<NodeHot> hot_;
+    arena_vector<NodeLinks> links_;
+    arena_vector<index_t> up_;
+};
+
 /**
  * DanceDD structure
  * 主类表示具有附加链接功能的ZDD
+ * @tparam Traits 整数位宽，见 ZddTraits。
  */
+template <typename Traits>
 class ZddWithLinks {
    public:
+    using count_t = typename Traits::count_t;
+    using index_t = typename Traits::index_t;
+    using plink_t = typename Traits::plink_t;
+    using var_t = typename Traits::var_t;
+    using trace_t = plink_t;  // node id << 1 | (1 if the hi-edge is taken)
+    using col_iterator = typename vector<var_t>::const_iterator;
+    using Node = ::Node<Traits>;
+    using NodeTable = ::NodeTable<Traits>;
+    using Header = ::Header<Traits>;
+    using DpManager = ::DpManager<Traits>;
+    using HiddenNodeStack = ::HiddenNodeStack<index_t>;
+
     // counters
     static uint64_t num_search_tree_nodes;
-    static uint64_t num_solutions;
+    static count128_t num_solutions;  // 分量之积可以超过64位，总是128位
     static uint64_t num_updates;            // 更新操作的数量
     static uint64_t num_head_updates;       // 头部更新的数量
     static uint64_t num_inactive_updates;   // 非活动更新的数量
     static uint64_t num_hides;              // 隐藏操作的数量
     static uint64_t num_failure_backtracks; // 失败回溯的数量
+    static uint64_t num_decompositions;     // 分解为多个连通分量的次数
+    static uint64_t num_recompressions;     // 提取残余子ZDD的次数
+    static uint64_t num_recompress_skips;   // 存活节点过多而不提取的次数
 
     ZddWithLinks(int num_var, bool sanity_check = false);
     ZddWithLinks(const ZddWithLinks &obj);
@@ -223,14 +500,153 @@ class ZddWithLinks {
      *@param solution-存储已找到解决方案。
      *@param depth-当前搜索深度。
      */
-    void search(vector<vector<uint16_t>> &solution, const int depth);
+    void search(vector<vector<var_t>> &solution, const int depth);
+
+    /**
+     * @brief 在假设下计数解，之后恢复为调用前的结构，不需要重新加载。
+     * @param assumptions 假设，列编号须在 1..num_var 中。
+     * @param solution 存储已找到的解。
+     * @return 解数。强制的选项不在实例中或同时被禁止，或强制的列和选项有重叠
+     *         （有上下界时为超过上界）时为0，不进行搜索。相同的强制选项视为一个。
+     * @details 强制的列和强制的选项的列以一次 batch_cover 覆盖，搜索后以
+     *          batch_uncover 回到隐藏节点栈的检查点。有上下界时各计一次覆盖，
+     *          只覆盖达到上界的列。禁止的选项（有上下界时还有强制的选项）在开始时
+     *          一次性删除：搜索提取的不含它们的残余子ZDD，原结构不变，
+     *          因此重新压缩、连通分量分解和ZDD之外的行都照常工作。
+     *          须在没有覆盖的列时调用。
+     */
+    count128_t count_with_assumptions(const Assumptions &assumptions,
+                                      vector<vector<var_t>> &solution);
+
+    /**
+     * @brief 把假设下的残余问题写入ZDD文件，之后恢复为调用前的结构。
+     * @param assumptions 假设，同 count_with_assumptions。
+     * @param file_name 输出的ZDD文件名，另写 .map 和 .secondary（见 write_zdd_to_file）。
+     * @param count 不写入时为不搜索即可得到的解数（0或1）。
+     * @return 写入时返回 true。假设矛盾、有无法覆盖的主列或没有存活节点时不写入。
+     * @details 禁止的选项不写入，写出的实例的解与查询的解一一对应。
+     */
+    bool write_residual_with_assumptions(const Assumptions &assumptions,
+                                         const string &file_name,
+                                         count128_t &count);
 
     /**
      * @brief 从文件加载ZDD数据。
      * @param file_name ZDD文件名。
+     * @details 读取后先经 reduce_zdd 检查并约简，再建立舞动链接。
      */
     void load_zdd_from_file(const string &file_name);
 
+    /**
+     * @brief 从已读取的ZDD建立舞动链接结构。
+     * @param zdd 读取的ZDD，见 RawZdd。zdd.secondary 中的列为次要列，搜索不在其上分支。
+     *            有 zdd.bounds 时按各列的覆盖次数的上下界搜索（见 search_with_bounds）。
+     */
+    void load_zdd(const RawZdd &zdd);
+
+    /**
+     * @brief 加载在ZDD之外以普通舞动链接行保存的选项（见 split_unshared_options）。
+     * @param rows 各行的列（升序），与ZDD的选项不重复。
+     * @details 应在 load_zdd 之后调用，各列的计数加上该列的行数。
+     *          覆盖列时这些行与ZDD的选项一起隐藏（Knuth的DLX），搜索时与ZDD的节点一起作为选择。
+     */
+    void load_side_rows(const SideRows &rows);
+
+    /**
+     * @brief 获取在ZDD之外保存的行数。
+     */
+    size_t num_side_rows() const {
+        return side_row_begin_.empty() ? 0 : side_row_begin_.size() - 1;
+    }
+
+    /**
+     * @brief 提取当前残余问题的紧凑子ZDD。
+     * @param excluded 不放入子ZDD的选项（原列编号，各选项的列升序）。
+     * @return 只包含存活节点、列重新编号后的新ZddWithLinks；
+     *         若不存在存活节点则返回 nullptr。
+     * @details 新结构的节点按 load_zdd_from_file 的顺序排列（var降序，根节点在最后），
+     *          可直接继续搜索。有上下界时存活的列保留上下界和已选择的次数。
+     */
+    unique_ptr<ZddWithLinks> extract_residual(
+        const vector<vector<var_t>> &excluded = {}) const;
+
+    /**
+     * @brief 将当前残余问题的存活节点以Graphillion格式写入文件。
+     * @param file_name 输出的ZDD文件名。
+     * @param excluded 不写入的选项（原列编号，各选项的列升序）。
+     * @return 写入时返回 true。没有存活节点，或有不在任何选项中的存活主列时返回 false。
+     * @details 列编号与 extract_residual 相同（存活的列按原编号升序重新编号）。
+     *          新列到原列的映射按 zdd_reorder 的格式写入 file_name.map，
+     *          存活的次要列写入 file_name.secondary。不支持ZDD之外的行。
+     */
+    bool write_zdd_to_file(const string &file_name,
+                           const vector<vector<var_t>> &excluded = {}) const;
+
+    /**
+     * @brief 将建立舞动链接后的结构写入快照文件。
+     * @param file_name 快照文件名。
+     * @details 格式见 snapshot.h。应在搜索之前调用。
+     */
+    void write_snapshot(const string &file_name) const;
+
+    /**
+     * @brief 从快照文件加载，代替 load_zdd。
+     * @param file_name 快照文件名，位宽和变量数须与该实例相同。
+     * @details 以MAP_PRIVATE映射文件并直接使用其中的数组，不重新计算计数和链接。
+     */
+    void load_snapshot(const string &file_name);
+
+    /**
+     * @brief 获取节点单元数。
+     */
+    size_t num_nodes() const { return table_.size(); }
+
+    /**
+     * @brief 设置在搜索中进行重新压缩的深度。
+     * @param depth 到达该深度时提取残余子ZDD并在其上继续搜索，负数表示不进行。
+     * @param max_live_ratio 只在存活的节点单元数不超过全部节点单元数的该比例时提取，
+     *                       否则在原结构上继续搜索。
+     */
+    void set_recompress_depth(int depth, double max_live_ratio) {
+        recompress_depth_ = depth;
+        recompress_ratio_ = max_live_ratio;
+    }
+
+    /**
+     * @brief 设置搜索中进行连通分量分解的间隔。
+     * @param interval 负数表示不进行，0表示只在根节点进行，n > 0 表示在根节点和每 n 层进行。
+     * @param cache_bytes 分量解数缓存的键的字节数上限，见 ComponentCache。
+     * @details 未覆盖的列之间若没有选项同时包含它们，残余问题分为相互独立的分量：
+     *          各分量分别求解，解数相乘。只统计解数，不输出各个解。
+     */
+    void set_decompose_interval(int interval, size_t cache_bytes);
+
+    /**
+     * @brief 获取分量解数缓存，未启用分解时返回 nullptr。
+     */
+    const ComponentCache *component_cache() const {
+        return component_cache_.get();
+    }
+
+    /**
+     * @brief 设置并行处理一层的最小节点数。
+     * @param threshold 上方向扫描中一层待处理的节点数达到该值时分块并行处理，0表示不并行。
+     * @details 需要以OpenMP编译，线程数由 OMP_NUM_THREADS 决定。
+     */
+    void set_parallel_level_threshold(size_t threshold) {
+        parallel_level_threshold_ = threshold;
+    }
+
+    /**
+     * @brief 设置并行建立舞动链接的最小节点数。
+     * @param threshold 节点单元数达到该值时 load_zdd 使用并行的建立过程，0表示总是串行。
+     * @details 应在 load_zdd 之前调用。并行与串行的结果完全相同（operator== 相等）。
+     *          以OpenMP编译且线程数大于1时才有效。
+     */
+    void set_parallel_setup_threshold(size_t threshold) {
+        parallel_setup_threshold_ = threshold;
+    }
+
     // check validity of the dancedd structure
     /**
      * @brief 检查DanceDD结构的有效性。
@@ -238,7 +654,68 @@ class ZddWithLinks {
      */
     bool sanity() const;
 
+    /**
+     * @brief 各数据结构实际占用的字节数，用于报告内存使用情况。
+     * @return (名称, 字节数) 的列表。每个深度的缓冲区合计为一项。
+     */
+    vector<pair<const char *, size_t>> footprint() const;
+
+    /**
+     * @brief 获取Arena，未使用时返回 nullptr。
+     */
+    const Arena *arena() const { return arena_.get(); }
+
    private:
+    /**
+     * a cell of the side matrix of rows kept besides the ZDD.
+     * Cells 0..num_var_ are the heads of the column lists; the cells of a row
+     * are contiguous in ascending column order.
+     * ZDD之外的行的单元。单元 0..num_var_ 为各列链表的头部，一行的单元按列升序连续排列。
+     */
+    struct SideCell {
+        var_t col;
+        index_t up;
+        index_t down;
+        index_t row;
+    };
+
+    /**
+     * diff of a parent produced while a level is processed in parallel.
+     * 并行处理一层时，向父节点传播的差异计数。
+     */
+    struct ParentDiff {
+        index_t parent_id;
+        count_t count;
+        var_t parent_var;
+        bool is_hi;
+    };
+
+    /**
+     * per-chunk buffers of a level processed in parallel. They are merged
+     * in chunk order, so the result equals that of the serial loop.
+     * 并行处理一层时每个块的缓冲区，按块的顺序合并，结果与串行处理相同。
+     */
+    struct LevelChunk {
+        vector<ParentDiff> diffs;
+        vector<index_t> hides;  // 计数变为0需要隐藏的节点（仅cover）
+        count_t head_delta;     // 列计数的变化量
+        uint64_t num_updates;
+        uint64_t num_inactive_updates;
+    };
+
+    /**
+     * @brief 分块并行处理上方向扫描中非覆盖列的一层。
+     * @param var 变量编号。
+     * @param cover true时为 batch_cover 的处理，false时为 batch_uncover 的处理。
+     */
+    void process_upper_level_parallel(var_t var, bool cover);
+
+    /**
+     * @brief 按节点数确定Arena的大小并建立Arena，之后的数组从中分配。
+     * @param num_nodes 节点单元数。
+     */
+    void prepare_arena(size_t num_nodes);
+
     /***
      * parent link operation methods.
      *
@@ -281,7 +758,7 @@ class ZddWithLinks {
     inline void plink_set_prev(plink_t addr, plink_t val) {
         assert((addr & 3LU) != 3LU);
         assert((val & 3LU) != 3LU);
-        Node &node = table_[plink_node_id(addr)];
+        auto node = table_[plink_node_id(addr)];
         if (plink_is_hi(addr)) {
             node.hi_prev = val;
         } else if (plink_is_term(addr)) {
@@ -299,7 +776,7 @@ class ZddWithLinks {
     inline void plink_set_next(plink_t addr, plink_t val) {
         assert((addr & 3LU) != 3LU);
         assert((val & 3LU) != 3LU);
-        Node &node = table_[plink_node_id(addr)];
+        auto node = table_[plink_node_id(addr)];
         if (plink_is_hi(addr)) {
             node.hi_next = val;
         } else if (plink_is_term(addr)) {
@@ -317,7 +794,7 @@ class ZddWithLinks {
     inline plink_t plink_get_prev(plink_t addr) const {
         assert((addr & 3LU) != 3LU);
 
-        const Node &node = table_[plink_node_id(addr)];
+        const auto node = table_[plink_node_id(addr)];
 
         if (plink_is_hi(addr)) {
             return node.hi_prev;
@@ -335,7 +812,7 @@ class ZddWithLinks {
      */
     inline plink_t plink_get_next(plink_t addr) const {
         assert((addr & 3LU) != 3LU);
-        const Node &node = table_[plink_node_id(addr)];
+        const auto node = table_[plink_node_id(addr)];
 
         if (plink_is_hi(addr)) {
             return node.hi_next;
@@ -349,17 +826,97 @@ class ZddWithLinks {
     /**
      * @brief 初始化舞动链接结构。
      * @details 设置节点计数、初始化上下链接关系以及管理动态规划。
+     *          节点数达到 parallel_setup_threshold_ 时使用并行版本。
      */
     void setup_dancing_links();
 
+    /**
+     * @brief 串行地计算计数、上下链接和父节点列表。
+     */
+    void setup_links_serial();
+
+    /**
+     * @brief 并行地计算计数、上下链接和父节点列表，结果与 setup_links_serial 相同。
+     * @details 子节点的var总是大于父节点，所以相同var的连续节点（层）之间没有边：
+     *          计数按层自下而上（下方计数）或自上而下（上方计数）在层内并行计算。
+     *          父节点列表按子节点分组（计数排序）后并行链接，
+     *          组内按父节点id升序、hi先于lo排列，与串行版本的插入顺序相同。
+     */
+    void setup_links_parallel();
+
+    /**
+     * @brief 收集当前残余问题的存活节点。
+     * @param column_map 输出新列编号到原列编号的映射。
+     * @param cells 输出存活节点的(新var, 新hi, 新lo)，按var降序排列。
+     * @details 存活节点即未覆盖列的down链表中的节点，hi/lo计数为0的分支视为⊥。
+     */
+    void collect_live_nodes(
+        vector<var_t> &column_map,
+        vector<tuple<var_t, index_t, index_t>> &cells) const;
+
+    /**
+     * @brief 收集当前残余问题中存活的ZDD之外的行。
+     * @param column_map collect_live_nodes 输出的新列编号到原列编号的映射。
+     * @param rows 输出存活的行，列为新编号。
+     * @details 存活的行即其所有列都未覆盖的行，出现在未覆盖列的链表中。
+     */
+    void collect_live_side_rows(const vector<var_t> &column_map,
+                                SideRows &rows) const;
+
+    /**
+     * @brief 获取当前残余问题中未覆盖的次要列。
+     * @param column_map collect_live_nodes 输出的新列编号到原列编号的映射。
+     * @return 次要列的新编号，升序。
+     */
+    vector<uint32_t> live_secondary_columns(
+        const vector<var_t> &column_map) const;
+
+    /**
+     * @brief 把列移到次要列的链表，须在建立舞动链接之后、搜索之前调用。
+     * @param columns 次要列，升序。
+     */
+    void set_secondary_columns(const vector<uint32_t> &columns);
+
+    /**
+     * @brief 隐藏ZDD之外的行中包含该列的行（从其他列的链表中移除），并减少其他列的计数。
+     */
+    void side_cover(var_t col);
+
+    /**
+     * @brief side_cover 的逆操作，须按相反的顺序调用。
+     */
+    void side_uncover(var_t col);
+
+    /**
+     * @brief 有ZDD之外的行时选择分支的列。
+     * @return ZDD中没有选项的列中计数最小的列；没有这样的列时，
+     *         为ZDD中选项数最小的列（相同时取头部顺序在前的列）。
+     * @details 按不含行的计数选择，与只有ZDD时的选择相同，
+     *          因此覆盖选择的列不会使其节点的祖先节点失去所有的hi路径。
+     */
+    int choose_column_with_side_rows() const;
+
+    /**
+     * @brief 若残余问题分为多个连通分量，分别求解各分量并把解数之积加到 num_solutions。
+     * @param solution 当前的部分解，传给各分量的搜索。
+     * @param depth 当前搜索深度。
+     * @return 进行了分解时返回 true，此时不再在该结构上继续搜索。
+     * @details 两列在同一选项中出现（即在存活节点的某条hi路径上）时相连。
+     *          各分量以 UniqueTable 构建约简的子ZDD，列按原顺序重新编号，
+     *          以其序列化作为 ComponentCache 的键。
+     *          解数之积以128位计算，超过128位时报错退出。
+     */
+    bool count_by_components(vector<vector<var_t>> &solution,
+                             const int depth);
+
     /**
      * @brief 批量覆盖给定列。
      * @param col_begin 列开始的迭代器。
      * @param col_end 列结束的迭代器。
      * @details 通过覆盖列来更新数据结构，隐藏相关节点。
      */
-    void batch_cover(const std::vector<uint16_t>::const_iterator col_begin,
-                     const std::vector<uint16_t>::const_iterator col_end);
+    void batch_cover(const col_iterator col_begin,
+                     const col_iterator col_end);
 
     /**
      * @brief 批量取消覆盖给定列。
@@ -367,8 +924,8 @@ class ZddWithLinks {
      * @param col_end 列结束的迭代器。
      * @details 通过取消覆盖列来恢复数据结构，显示相关节点。
      */
-    void batch_uncover(const std::vector<uint16_t>::const_iterator col_begin,
-                       const std::vector<uint16_t>::const_iterator col_end);
+    void batch_uncover(const col_iterator col_begin,
+                       const col_iterator col_end);
     
     
     /**
@@ -378,8 +935,85 @@ class ZddWithLinks {
      * @param choice 输出选择的列。
      * @details 根据当前节点和计数ID，计算出上方向的选择路径。
      */
-    void compute_upper_choice(int32_t node_id, count_t up_id,
-                              vector<uint16_t> &choice) noexcept;
+    void compute_upper_choice(index_t node_id, count_t up_id,
+                              vector<var_t> &choice) noexcept;
+
+    /**
+     * @brief 设置各列的覆盖次数的上下界，须在 set_secondary_columns 之后调用。
+     * @param bounds 上下界，下界为0的列须为次要列。未给出的列恰好覆盖一次（次要列至多一次）。
+     */
+    void set_column_bounds(const vector<ColumnBounds> &bounds);
+
+    /**
+     * @brief 有覆盖次数的上下界时的搜索。
+     * @param solution 当前的部分解。
+     * @param depth 当前搜索深度，即已选择的选项数。
+     * @details 在主列中选择分支列c，按包含c的选项X分支，
+     *          X为其余选择的选项中包含c的字典序最小的选项：之后选择的包含c的选项须大于X，
+     *          因此同一组选项只以一种顺序得到（Knuth的Algorithm M的重数）。
+     *          c已达到下界时另有不再选择包含c的选项的分支，覆盖c。
+     *          选择X时各列的计数加一，达到上界的列被覆盖。
+     *          X若没有被覆盖的列仍留在ZDD中，由字典序的条件排除。
+     */
+    void search_with_bounds(vector<vector<var_t>> &solution, const int depth);
+
+    /**
+     * @brief 沿存活的hi/lo边枚举选项的下方向部分，对每个选项调用 choose_option_with_bounds。
+     * @param node_id 下方向的起始节点或终端。
+     * @param column 分支列。
+     * @param solution 当前的部分解。
+     * @param depth 当前搜索深度，选项的列在 depth_option_buf_[depth] 中。
+     */
+    void enumerate_lower_options(index_t node_id, var_t column,
+                                 vector<vector<var_t>> &solution,
+                                 const int depth);
+
+    /**
+     * @brief 检查ZDD或ZDD之外的行是否包含选项，须在没有覆盖的列时调用。
+     * @param option 选项的列，升序。
+     * @return 包含时返回 true。
+     */
+    bool contains_option(const vector<uint32_t> &option) const;
+
+    /**
+     * @brief 覆盖查询假设的列，求出要从残余问题中删除的选项。
+     * @param assumptions 查询的假设。
+     * @param columns 输出强制的列和强制的选项的列（升序，有上下界时可以重复）。
+     * @param covered 输出以 batch_cover 覆盖的列。
+     * @param excluded 输出要删除的选项（升序且不重复）。
+     * @return 假设矛盾时不覆盖并返回 false。
+     */
+    bool apply_assumptions(const Assumptions &assumptions,
+                           vector<var_t> &columns, vector<var_t> &covered,
+                           vector<vector<var_t>> &excluded);
+
+    /**
+     * @brief 恢复 apply_assumptions 覆盖的列和覆盖次数。
+     */
+    void restore_assumptions(const vector<var_t> &columns,
+                             const vector<var_t> &covered);
+
+    /**
+     * @brief 不再选择选项时，存活的主列是否都已满足（有上下界时达到下界）。
+     */
+    bool live_primary_satisfied() const;
+
+    /**
+     * @brief 从 extract_residual 收集的存活节点和行中删除选项。
+     */
+    static void remove_live_options(
+        const vector<var_t> &column_map, const vector<vector<var_t>> &options,
+        vector<tuple<var_t, index_t, index_t>> &cells, SideRows &rows);
+
+    /**
+     * @brief 选择 depth_option_buf_[depth] 中的选项，搜索下一个深度后恢复。
+     * @param column 分支列。
+     * @param solution 当前的部分解。
+     * @param depth 当前搜索深度。
+     */
+    void choose_option_with_bounds(var_t column,
+                                   vector<vector<var_t>> &solution,
+                                   const int depth);
 
     /**
      * @brief 初始化上方向的选择。
@@ -390,11 +1024,11 @@ class ZddWithLinks {
      * @param choices_buf 用于存储选择的缓冲区。
      * @details 初始化上方向的选择路径，记录访问的节点和变化的选择。
      */
-    void compute_upper_initial_choice(int32_t node_id,
-                                      vector<uint32_t> &visited,
+    void compute_upper_initial_choice(index_t node_id,
+                                      vector<trace_t> &visited,
                                       vector<size_t> &diff_choices,
-                                      vector<int32_t> &diff_choice_ids,
-                                      vector<uint16_t> &choices_buf) noexcept;
+                                      vector<index_t> &diff_choice_ids,
+                                      vector<var_t> &choices_buf) noexcept;
 
     /**
      * @brief 计算上方向的下一个选择。
@@ -405,10 +1039,10 @@ class ZddWithLinks {
      * @return 如果没有更多选择则返回 true，否则返回 false。
      * @details 计算上方向的下一个选择路径，更新访问的节点和变化的选择。
      */
-    bool compute_upper_next_choice(vector<uint32_t> &visited,
+    bool compute_upper_next_choice(vector<trace_t> &visited,
                                    vector<size_t> &diff_choices,
-                                   vector<int32_t> &diff_choice_ids,
-                                   vector<uint16_t> &choice_buf);
+                                   vector<index_t> &diff_choice_ids,
+                                   vector<var_t> &choice_buf);
     
     /**
      * @brief 计算下方向的选择。
@@ -417,8 +1051,8 @@ class ZddWithLinks {
      * @param choice 输出选择的列。
      * @details 根据当前节点和计数ID，计算出下方向的选择路径。
      */
-    void compute_lower_choice(int32_t node_id, count_t down_id,
-                              vector<uint16_t> &choice) noexcept;
+    void compute_lower_choice(index_t node_id, count_t down_id,
+                              vector<var_t> &choice) noexcept;
     
     /**
      * @brief 初始化下方向的选择。
@@ -428,10 +1062,10 @@ class ZddWithLinks {
      * @param choices_buf 用于存储选择的缓冲区。
      * @details 初始化下方向的选择路径，记录访问的节点和变化的选择。
      */
-    void compute_lower_initial_choice(const int32_t start_id,
-                                      vector<uint32_t> &visited,
+    void compute_lower_initial_choice(const index_t start_id,
+                                      vector<trace_t> &visited,
                                       vector<size_t> &diff_choices,
-                                      vector<uint16_t> &choices_buf);
+                                      vector<var_t> &choices_buf);
     
     /**
      * @brief 计算下方向的下一个选择。
@@ -441,9 +1075,9 @@ class ZddWithLinks {
      * @return 如果没有更多选择则返回 true，否则返回 false。
      * @details 计算下方向的下一个选择路径，更新访问的节点和变化的选择。
      */
-    bool compute_lower_next_choice(vector<uint32_t> &visited,
+    bool compute_lower_next_choice(vector<trace_t> &visited,
                                    vector<size_t> &diff_choices,
-                                   vector<uint16_t> &choice_buf);
+                                   vector<var_t> &choice_buf);
     
     /**
      * @brief 将跟踪信息转换为选择集。
@@ -454,10 +1088,10 @@ class ZddWithLinks {
      */
     template <typename ForwardIterator>
     void trace2choice(ForwardIterator begin, ForwardIterator end,
-                      vector<uint16_t> &choice) const {
+                      vector<var_t> &choice) const {
         choice.clear();
         for (auto it = begin; it != end; ++it) {
-            uint32_t val = *it;
+            trace_t val = *it;
             if (val & 1U) {
                 choice.push_back(table_[val >> 1U].var);
             }
@@ -467,26 +1101,26 @@ class ZddWithLinks {
      * @brief 隐藏指定的节点。
      * @param node_id 要隐藏的节点ID。
      */
-    void hide_node(const int32_t node_id);
+    void hide_node(const index_t node_id);
 
     /**
      * @brief 隐藏cover_down类型的节点。
      * @param node_id 要隐藏的节点ID。
      */
-    void hide_node_cover_down(const int32_t node_id);
-    void hide_node_cover_up(const int32_t node_id);
-    void hide_node_upperzero(const int32_t node_id);
-    void hide_node_lowerzero(const int32_t node_id);
+    void hide_node_cover_down(const index_t node_id);
+    void hide_node_cover_up(const index_t node_id);
+    void hide_node_upperzero(const index_t node_id);
+    void hide_node_lowerzero(const index_t node_id);
 
-    void unhide_node(const int32_t node_id);
+    void unhide_node(const index_t node_id);
     
-    void unhide_node_cover_down(const int32_t node_id);
-    void unhide_node_cover_up(const int32_t node_id);
-    void unhide_node_upperzero(const int32_t node_id);
-    void unhide_node_lowerzero(const int32_t node_id);
+    void unhide_node_cover_down(const index_t node_id);
+    void unhide_node_cover_up(const index_t node_id);
+    void unhide_node_upperzero(const index_t node_id);
+    void unhide_node_lowerzero(const index_t node_id);
 
-    void print_parent_links(const int32_t node_id) const {
-        const Node &node = table_[node_id];
+    void print_parent_links(const index_t node_id) const {
+        const auto node = table_[node_id];
         std::cerr << node_id << ", ";
         for (plink_t plink = node.parents_head;;
              plink = plink_get_next(plink)) {
@@ -512,33 +1146,81 @@ class ZddWithLinks {
 
     const int num_var_;
 
+    // 节点单元、头部单元等数组所在的Arena，必须比这些数组存在得更久
+    unique_ptr<Arena> arena_;
     // storing the node cells
-    vector<Node> table_;
-    // storing the header cells
-    vector<Header> header_;
+    NodeTable table_;
+    // storing the header cells: header_[0] heads the list of uncovered primary
+    // columns and header_[num_var_ + 1] the list of uncovered secondary columns
+    arena_vector<Header> header_;
     // 动态规划管理器的智能指针
     unique_ptr<DpManager> dp_mgr_;
     // 隐藏节点栈的智能指针
     unique_ptr<HiddenNodeStack> hidden_node_stack_;
     // 是否进行完整性检查的标志
     const bool sanity_check_;
+    // 重新压缩残余问题的搜索深度，负数表示不进行
+    int recompress_depth_;
+    // 进行重新压缩的存活节点单元的最大比例
+    double recompress_ratio_;
+    // 连通分量分解的间隔，负数表示不进行，0表示只在根节点进行
+    int decompose_interval_;
+    // 不进行分解的深度：分量的子结构在创建时的深度已经是连通的
+    int skip_decompose_depth_;
+    // 分量解数缓存，由分解出的子结构共享
+    shared_ptr<ComponentCache> component_cache_;
+    // 并行处理一层的最小节点数，0表示不并行
+    size_t parallel_level_threshold_;
+    // 并行建立舞动链接的最小节点数，0表示总是串行
+    size_t parallel_setup_threshold_;
+    // 并行处理一层时各块的缓冲区
+    vector<LevelChunk> level_chunks_;
+    // ZDD之外的行的单元，没有这样的行时为空
+    vector<SideCell> side_cells_;
+    // 行r的单元为 side_cells_[side_row_begin_[r] .. side_row_begin_[r + 1])
+    vector<index_t> side_row_begin_;
+    // side_count_[c]: 列c中存活的行数，header_[c].count 包含这些行
+    vector<count_t> side_count_;
+    // 各列的覆盖次数的上下界，没有上下界（都恰好覆盖一次或至多一次）时为空
+    vector<uint32_t> min_cover_;
+    vector<uint32_t> max_cover_;
+    // num_covered_[c]: 已选择的包含列c的选项数
+    vector<uint32_t> num_covered_;
+    // min_option_depth_[c]: 以c为分支列最后选择的选项所在的深度，没有时为-1。
+    // 之后选择的包含c的选项须按字典序大于该选项
+    vector<int> min_option_depth_;
+    // 各深度选择的选项的列（升序）
+    vector<vector<var_t>> depth_option_buf_;
 
     // buffers used in the search.
     // 搜索过程中每个深度的选择缓冲区
-    vector<vector<uint16_t>> depth_choice_buf_;
+    vector<vector<var_t>> depth_choice_buf_;
     // 上方向选择的缓冲区。用于记录和管理上方向的选择路径。
-    vector<vector<uint16_t>> depth_upper_choice_buf_;
+    vector<vector<var_t>> depth_upper_choice_buf_;
     // 下方向选择的缓冲区
-    vector<vector<uint16_t>> depth_lower_choice_buf_;
+    vector<vector<var_t>> depth_lower_choice_buf_;
     // 下方向的跟踪信息缓冲区
-    vector<vector<uint32_t>> depth_lower_trace_buf_;
+    vector<vector<trace_t>> depth_lower_trace_buf_;
     // 下方向选择变化的索引缓冲区
     vector<vector<size_t>> depth_lower_change_pts_buf_;
     // 上方向的跟踪信息缓冲区。帮助在搜索过程中记录访问的节点和路径。
-    vector<vector<uint32_t>> depth_upper_trace_buf_;
+    vector<vector<trace_t>> depth_upper_trace_buf_;
     // 上方向选择变化的索引缓冲区。用于记录和管理选择路径中涉及的节点变化。
     vector<vector<size_t>> depth_upper_change_pts_buf_;
     // 上方向选择变化的节点ID缓冲区。用于记录和管理选择路径中涉及的节点变化。
-    vector<vector<int32_t>> depth_upper_change_node_ids_buf_;
+    vector<vector<index_t>> depth_upper_change_node_ids_buf_;
 };
+
+extern template class ZddWithLinks<ZddTraits<uint32_t, int32_t, uint16_t>>;
+extern template class ZddWithLinks<ZddTraits<uint32_t, int32_t, uint32_t>>;
+extern template class ZddWithLinks<ZddTraits<uint32_t, int64_t, uint16_t>>;
+extern template class ZddWithLinks<ZddTraits<uint32_t, int64_t, uint32_t>>;
+extern template class ZddWithLinks<ZddTraits<uint64_t, int32_t, uint16_t>>;
+extern template class ZddWithLinks<ZddTraits<uint64_t, int32_t, uint32_t>>;
+extern template class ZddWithLinks<ZddTraits<uint64_t, int64_t, uint16_t>>;
+extern template class ZddWithLinks<ZddTraits<uint64_t, int64_t, uint32_t>>;
+extern template class ZddWithLinks<ZddTraits<count128_t, int32_t, uint16_t>>;
+extern template class ZddWithLinks<ZddTraits<count128_t, int32_t, uint32_t>>;
+extern template class ZddWithLinks<ZddTraits<count128_t, int64_t, uint16_t>>;
+extern template class ZddWithLinks<ZddTraits<count128_t, int64_t, uint32_t>>;
 #endif  // DANCING_ON_ZDD_H_
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "decompress.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef D3X_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef D3X_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+Compression detect_compression(const string &file_name) {
+    FILE *fp = fopen(file_name.c_str(), "rb");
+    if (!fp) return Compression::None;
+    unsigned char magic[4] = {0, 0, 0, 0};
+    const size_t n = fread(magic, 1, sizeof(magic), fp);
+    fclose(fp);
+    if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        return Compression::Gzip;
+    }
+    if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f &&
+        magic[3] == 0xfd) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+DecompressStream::DecompressStream(const string &file_name,
+                                   Compression compression)
+    : file_name_(file_name),
+      compression_(compression),
+      gz_(nullptr),
+      fp_(nullptr),
+      zstd_(nullptr),
+      in_size_(0),
+      in_pos_(0),
+      frame_done_(true) {
+    if (compression_ == Compression::Gzip) {
+#ifdef D3X_HAVE_ZLIB
+        gzFile gz = gzopen(file_name.c_str(), "rb");
+        if (!gz) {
+            cerr << "can't open " << file_name << endl;
+            exit(1);
+        }
+        gzbuffer(gz, 1 << 20);
+        gz_ = gz;
+#else
+        cerr << file_name << " is gzip-compressed, but d3x was built "
+             << "without zlib" << endl;
+        exit(1);
+#endif
+    } else if (compression_ == Compression::Zstd) {
+#ifdef D3X_HAVE_ZSTD
+        fp_ = fopen(file_name.c_str(), "rb");
+        if (!fp_) {
+            cerr << "can't open " << file_name << endl;
+            exit(1);
+        }
+        ZSTD_DStream *ds = ZSTD_createDStream();
+        ZSTD_initDStream(ds);
+        zstd_ = ds;
+        in_buf_.resize(ZSTD_DStreamInSize());
+#else
+        cerr << file_name << " is zstd-compressed, but d3x was built "
+             << "without libzstd" << endl;
+        exit(1);
+#endif
+    }
+}
+
+DecompressStream::~DecompressStream() {
+#ifdef D3X_HAVE_ZLIB
+    if (gz_) gzclose(static_cast<gzFile>(gz_));
+#endif
+#ifdef D3X_HAVE_ZSTD
+    if (zstd_) ZSTD_freeDStream(static_cast<ZSTD_DStream *>(zstd_));
+#endif
+    if (fp_) fclose(fp_);
+}
+
+size_t DecompressStream::read(char *buf, size_t size) {
+#ifdef D3X_HAVE_ZLIB
+    if (gz_) {
+        const int n = gzread(static_cast<gzFile>(gz_), buf, size);
+        // 文件被截断时 gzread 返回已读的数据，gzerror 报告 Z_BUF_ERROR
+        int errnum = Z_OK;
+        const char *message = gzerror(static_cast<gzFile>(gz_), &errnum);
+        if (n < 0 || (errnum != Z_OK && errnum != Z_STREAM_END)) {
+            cerr << "failed to decompress " << file_name_ << ": " << message
+                 << endl;
+            exit(1);
+        }
+        return n;
+    }
+#endif
+#ifdef D3X_HAVE_ZSTD
+    if (zstd_) {
+        ZSTD_outBuffer out = {buf, size, 0};
+        while (out.pos < out.size) {
+            if (in_pos_ == in_size_) {
+                in_size_ = fread(in_buf_.data(), 1, in_buf_.size(), fp_);
+                in_pos_ = 0;
+                if (in_size_ == 0) {
+                    if (!frame_done_) {
+                        cerr << "failed to decompress " << file_name_
+                             << ": truncated input" << endl;
+                        exit(1);
+                    }
+                    break;
+                }
+            }
+            ZSTD_inBuffer in = {in_buf_.data(), in_size_, in_pos_};
+            const size_t ret = ZSTD_decompressStream(
+                static_cast<ZSTD_DStream *>(zstd_), &out, &in);
+            if (ZSTD_isError(ret)) {
+                cerr << "failed to decompress " << file_name_ << ": "
+                     << ZSTD_getErrorName(ret) << endl;
+                exit(1);
+            }
+            in_pos_ = in.pos;
+            frame_done_ = ret == 0;
+        }
+        return out.pos;
+    }
+#endif
+    (void)buf;
+    (void)size;
+    return 0;
+}
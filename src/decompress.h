@@ -0,0 +1,60 @@
+#ifndef DECOMPRESS_H_
+#define DECOMPRESS_H_
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * compression formats of input files, detected by their magic bytes.
+ * 输入文件的压缩格式，根据文件开头的魔数判断。
+ */
+enum class Compression { None, Gzip, Zstd };
+
+/**
+ * @brief 判断文件的压缩格式。
+ * @param file_name 文件名。
+ * @return 压缩格式。无法打开时返回 Compression::None。
+ */
+Compression detect_compression(const std::string &file_name);
+
+/**
+ * Streaming decompressor of a gzip (zlib) or zstd (libzstd) file.
+ * Formats whose library was not found at build time are reported as
+ * errors when the stream is opened.
+ * gzip（zlib）或zstd（libzstd）文件的流式解压。构建时未找到对应库的格式在打开时报错。
+ */
+class DecompressStream {
+   public:
+    /**
+     * @brief 打开压缩文件。失败时报错并退出。
+     * @param file_name 文件名。
+     * @param compression 压缩格式，Gzip 或 Zstd。
+     */
+    DecompressStream(const std::string &file_name, Compression compression);
+    ~DecompressStream();
+    DecompressStream(const DecompressStream &) = delete;
+    DecompressStream &operator=(const DecompressStream &) = delete;
+
+    /**
+     * @brief 读取解压后的数据。
+     * @param buf 输出缓冲区。
+     * @param size 缓冲区的字节数。
+     * @return 读取的字节数，到达文件末尾时返回0。出错时报错并退出。
+     */
+    size_t read(char *buf, size_t size);
+
+   private:
+    const std::string file_name_;
+    const Compression compression_;
+    void *gz_;      // gzFile
+    FILE *fp_;      // zstd的输入文件
+    void *zstd_;    // ZSTD_DStream
+    std::vector<char> in_buf_;  // zstd的压缩数据缓冲区
+    size_t in_size_;
+    size_t in_pos_;
+    bool frame_done_;  // zstd的帧是否已完整解压
+};
+
+#endif  // DECOMPRESS_H_
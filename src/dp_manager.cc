@@ -2,23 +2,38 @@
 
 using namespace std;
 
-DpManager::DpManager(const vector<Node> &nodes, const int num_var)
-    : table_elems_(nodes.size(), 0),
-      var_heads_(num_var + 1, 0),
-      num_elems_(num_var + 1, 0),
-      diff_counter_(nodes.size(), 0),
-      diff_counter_hi_(nodes.size(), 0),
+template <typename Traits>
+DpManager<Traits>::DpManager(const NodeTable<Traits> &nodes,
+                             const int num_var, Arena *arena)
+    : table_elems_(nodes.size(), 0, arena),
+      var_heads_(num_var + 1, 0, arena),
+      num_elems_(num_var + 1, 0, arena),
+      diff_counter_(nodes.size(), 0, arena),
+      diff_counter_hi_(nodes.size(), 0, arena),
       entries_counter_(0),
       num_var_(num_var),
-      upper_varorder_pq_(),
-      lower_varorder_pq_() {
+      lower_levels_(num_var),
+      upper_levels_(num_var) {
     int previous_var = -1;
     
     for (size_t i = 0; i < nodes.size(); i++) {
-        const Node &node = nodes[i];
+        const auto node = nodes[i];
         if (node.var != previous_var) {
             var_heads_[node.var] = i;
             previous_var = node.var;
         }
     }
 }
+
+template class DpManager<ZddTraits<uint32_t, int32_t, uint16_t>>;
+template class DpManager<ZddTraits<uint32_t, int32_t, uint32_t>>;
+template class DpManager<ZddTraits<uint32_t, int64_t, uint16_t>>;
+template class DpManager<ZddTraits<uint32_t, int64_t, uint32_t>>;
+template class DpManager<ZddTraits<uint64_t, int32_t, uint16_t>>;
+template class DpManager<ZddTraits<uint64_t, int32_t, uint32_t>>;
+template class DpManager<ZddTraits<uint64_t, int64_t, uint16_t>>;
+template class DpManager<ZddTraits<uint64_t, int64_t, uint32_t>>;
+template class DpManager<ZddTraits<count128_t, int32_t, uint16_t>>;
+template class DpManager<ZddTraits<count128_t, int32_t, uint32_t>>;
+template class DpManager<ZddTraits<count128_t, int64_t, uint16_t>>;
+template class DpManager<ZddTraits<count128_t, int64_t, uint32_t>>;
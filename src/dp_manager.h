@@ -2,26 +2,141 @@
 #define DP_MANAGER_H_
 
 #include <memory>
-#include <queue>
 #include <vector>
 
+#include "arena.h"
 #include "dancing_on_zdd.h"
 
+/**
+ * A set of pending levels (vars) stored as a two-level bitmap.
+ * pop_min / pop_max return the smallest / largest pending var in O(1) word
+ * scans with ctz / clz, replacing binary heaps in the level sweeps.
+ * 待处理层（变量）的两级位图。
+ * 下层每个字表示64个变量，上层每一位表示下层的一个字是否非空。
+ * 在下方向扫描中新加入的变量总是大于刚取出的变量（上方向扫描中则总是更小），
+ * 因此用 min_word_ / max_word_ 记录非空字的范围即可避免从头扫描。
+ * 一次扫描的待处理层通常只有几个，每次取出的开销决定速度：变量数小于64时只使用一个字，
+ * 不经过上层和范围；否则用 size_ 在为空时直接返回。
+ */
+template <typename Var>
+class LevelBitmap {
+   public:
+    /**
+     * @brief 构造函数。
+     * @param num_levels 变量的最大编号。
+     */
+    explicit LevelBitmap(size_t num_levels)
+        : words_((num_levels >> 6) + 1, 0),
+          summary_((words_.size() >> 6) + 1, 0),
+          min_word_(words_.size()),
+          max_word_(0),
+          single_(words_.size() == 1) {}
+
+    /**
+     * @brief 加入变量。已存在时不做任何操作。
+     * @param var 变量编号（非0）。
+     */
+    void insert(Var var) {
+        if (single_) {
+            words_[0] |= 1ULL << var;
+            return;
+        }
+        const size_t w = var >> 6;
+        const uint64_t bit = 1ULL << (var & 63);
+        if (words_[w] & bit) return;
+        if (!words_[w]) {
+            summary_[w >> 6] |= 1ULL << (w & 63);
+            if (w < min_word_) min_word_ = w;
+            if (w > max_word_) max_word_ = w;
+        }
+        words_[w] |= bit;
+        size_++;
+    }
+
+    /**
+     * @brief 取出并删除最小的变量。
+     * @return 变量编号。为空时返回0。
+     */
+    Var pop_min() {
+        if (single_) {
+            uint64_t &w0 = words_[0];
+            if (!w0) return 0;
+            const Var var = __builtin_ctzll(w0);
+            w0 &= w0 - 1;
+            return var;
+        }
+        if (size_ == 0) return 0;
+        size_t s = min_word_ >> 6;
+        while (!summary_[s]) s++;
+        const size_t w = (s << 6) + __builtin_ctzll(summary_[s]);
+        const Var var = (w << 6) + __builtin_ctzll(words_[w]);
+        words_[w] &= words_[w] - 1;
+        if (!words_[w]) summary_[s] &= ~(1ULL << (w & 63));
+        min_word_ = w;
+        if (--size_ == 0) clear_range();
+        return var;
+    }
+
+    /**
+     * @brief 取出并删除最大的变量。
+     * @return 变量编号。为空时返回0。
+     */
+    Var pop_max() {
+        if (single_) {
+            uint64_t &w0 = words_[0];
+            if (!w0) return 0;
+            const int bit = 63 - __builtin_clzll(w0);
+            w0 &= ~(1ULL << bit);
+            return bit;
+        }
+        if (size_ == 0) return 0;
+        size_t s = max_word_ >> 6;
+        while (!summary_[s]) s--;
+        const size_t w = (s << 6) + 63 - __builtin_clzll(summary_[s]);
+        const int bit = 63 - __builtin_clzll(words_[w]);
+        const Var var = (w << 6) + bit;
+        words_[w] &= ~(1ULL << bit);
+        if (!words_[w]) summary_[s] &= ~(1ULL << (w & 63));
+        max_word_ = w;
+        if (--size_ == 0) clear_range();
+        return var;
+    }
+
+   private:
+    // 变为空时重置非空字的范围
+    void clear_range() {
+        min_word_ = words_.size();
+        max_word_ = 0;
+    }
+
+    std::vector<uint64_t> words_;    // 每位表示一个变量
+    std::vector<uint64_t> summary_;  // 每位表示 words_ 的一个字是否非空
+    size_t min_word_;                // 非空字的下界
+    size_t max_word_;                // 非空字的上界
+    size_t size_ = 0;                // 待处理的变量数
+    const bool single_;              // 变量都在一个字中
+};
+
 /**
  * A class having dp tables for cover / uncover operaitons.
  *  When performing cover/uncover operations, the order must be reversed. 
  *  the class stores the order of processed node cell ids.
  */
-
-struct Node;
+template <typename Traits>
 class DpManager {
    public:
+    using count_t = typename Traits::count_t;
+    using index_t = typename Traits::index_t;
+    using var_t = typename Traits::var_t;
+
    /**
     * 构造函数，初始化动态规划管理器。
     * @param nodes 节点的向量引用。
     * @param num_var 变量的数量。
+    * @param arena 分配各数组的Arena，nullptr 时使用堆。
     */
-    DpManager(const std::vector<Node> &nodes, const int num_var);
+    DpManager(const NodeTable<Traits> &nodes, const int num_var,
+              Arena *arena = nullptr);
     // 禁用拷贝构造函数，防止对象被复制。
     DpManager(const DpManager &obj) = delete;
 
@@ -31,9 +146,9 @@ class DpManager {
      * @param node_id 节点ID。
      * @param count 增加的计数。
      * 如果节点的差异计数大于0，则不进行操作
-     * 否则，更新表格元素并将变量加入优先队列
+     * 否则，更新表格元素并将变量加入待处理层
      */
-    void add_node_diff_count(uint16_t var, int32_t node_id, count_t count) {
+    void add_node_diff_count(var_t var, index_t node_id, count_t count) {
         diff_counter_[node_id] += count;
         if (diff_counter_[node_id] > count) {
             return;
@@ -43,7 +158,7 @@ class DpManager {
         num_elems_[var]++;
         table_elems_[var_heads_[var] + var_num_elems] = node_id;
         if (!var_num_elems) {
-            lower_varorder_pq_.push(var);
+            lower_levels_.insert(var);
         }
     }
 
@@ -53,9 +168,9 @@ class DpManager {
      * @param node_id 节点ID。
      * @param count 增加的计数。
      * 如果节点的差异计数或高分支差异计数大于0，则只增加高分支差异计数。
-     * 否则，更新表格元素并将变量加入优先队列。
+     * 否则，更新表格元素并将变量加入待处理层。
      */
-    void add_node_diff_count_high(uint16_t var, int32_t node_id,
+    void add_node_diff_count_high(var_t var, index_t node_id,
                                   count_t count) {
         if (diff_counter_[node_id] > 0 || diff_counter_hi_[node_id] > 0) {
             diff_counter_hi_[node_id] += count;
@@ -66,7 +181,7 @@ class DpManager {
         table_elems_[var_heads_[var] + num_elems_[var]] = node_id;
         num_elems_[var]++;
         if (num_elems_[var] == 1) {
-            upper_varorder_pq_.push(var);
+            upper_levels_.insert(var);
         }
     }
 
@@ -76,9 +191,9 @@ class DpManager {
      * @param node_id 节点ID。
      * @param count 增加的计数。
      * 如果节点的差异计数或高分支差异计数大于0，则只增加差异计数。
-     * 否则，更新表格元素并将变量加入优先队列。
+     * 否则，更新表格元素并将变量加入待处理层。
      */
-    void add_node_diff_count_low(uint16_t var, int32_t node_id, count_t count) {
+    void add_node_diff_count_low(var_t var, index_t node_id, count_t count) {
         if (diff_counter_[node_id] > 0 || diff_counter_hi_[node_id] > 0) {
             diff_counter_[node_id] += count;
             return;
@@ -88,7 +203,7 @@ class DpManager {
         table_elems_[var_heads_[var] + num_elems_[var]] = node_id;
         num_elems_[var]++;
         if (num_elems_[var] == 1) {
-            upper_varorder_pq_.push(var);
+            upper_levels_.insert(var);
         }
     }
 
@@ -98,7 +213,7 @@ class DpManager {
      * @param i 索引。
      * @return 节点ID。
      */
-    inline int32_t at(uint16_t var, int32_t i) const noexcept {
+    inline index_t at(var_t var, index_t i) const noexcept {
         return table_elems_[var_heads_[var] + i];
     }
 
@@ -107,21 +222,21 @@ class DpManager {
      * @param var 变量编号。
      * @return 元素数量。
      */
-    int32_t num_elems(uint16_t var) const { return num_elems_[var]; }
+    index_t num_elems(var_t var) const { return num_elems_[var]; }
 
     /**
      * 获取指定节点的差异计数。
      * @param node_id 节点ID。
      * @return 差异计数。
      */
-    count_t count_at(int32_t node_id) const { return diff_counter_[node_id]; }
+    count_t count_at(index_t node_id) const { return diff_counter_[node_id]; }
 
     /**
      * 获取指定节点的低分支差异计数。
      * @param node_id 节点ID。
      * @return 低分支差异计数。
      */
-    count_t low_count_at(int32_t node_id) const {
+    count_t low_count_at(index_t node_id) const {
         return diff_counter_[node_id];
     }
 
@@ -130,7 +245,7 @@ class DpManager {
      * @param node_id 节点ID。
      * @return 高分支差异计数。
      */
-    count_t high_count_at(int32_t node_id) const {
+    count_t high_count_at(index_t node_id) const {
         return diff_counter_hi_[node_id];
     }
 
@@ -139,7 +254,7 @@ class DpManager {
      * @param node_id 节点ID。
      * @return 差异计数。
      */
-    count_t get_count_and_clear(const int32_t node_id) {
+    count_t get_count_and_clear(const index_t node_id) {
         auto c = diff_counter_[node_id];
         diff_counter_[node_id] = 0;
         return c;
@@ -150,7 +265,7 @@ class DpManager {
      * @param node_id 节点ID。
      * @return 低分支差异计数。
      */
-    count_t get_low_count_and_clear(const int32_t node_id) {
+    count_t get_low_count_and_clear(const index_t node_id) {
         auto c = diff_counter_[node_id];
         diff_counter_[node_id] = 0;
         return c;
@@ -161,7 +276,7 @@ class DpManager {
      * @param node_id 节点ID。
      * @return 高分支差异计数。
      */
-    count_t get_high_count_and_clear(const int32_t node_id) {
+    count_t get_high_count_and_clear(const index_t node_id) {
         auto c = diff_counter_hi_[node_id];
         diff_counter_hi_[node_id] = 0;
         return c;
@@ -171,14 +286,14 @@ class DpManager {
      * 清除指定变量的计数器。
      * @param var 变量编号。
      */
-    void clear_var_counter(uint16_t var) { num_elems_[var] = 0; }
+    void clear_var_counter(var_t var) { num_elems_[var] = 0; }
 
     /**
      * 清除指定变量的元素。
      * @param var 变量编号。
      * 清除与该变量相关的所有节点的差异计数。
      */
-    void clear_var_elems(uint16_t var) {
+    void clear_var_elems(var_t var) {
         for (size_t i = 0; i < num_elems_[var]; i++) {
             auto node_id = at(var, i);
             diff_counter_[node_id] = 0UL;
@@ -190,59 +305,78 @@ class DpManager {
     /**
      * 获取上方向非零变量。
      * @return 非零变量编号。
-     * 如果优先队列为空，则返回0
+     * 没有待处理的变量时返回0。
      */
-    uint16_t upper_nonzero_var() {
-        if (upper_varorder_pq_.empty()) return 0;
-
-        uint16_t next = upper_varorder_pq_.top();
-        upper_varorder_pq_.pop();
-        return next;
-    }
+    var_t upper_nonzero_var() { return upper_levels_.pop_max(); }
 
     /**
      * 获取下方向非零变量。
      * @return 非零变量编号。
-     * 如果优先队列为空，则返回0。
+     * 没有待处理的变量时返回0。
      */
-    uint16_t lower_nonzero_var() {
-        if (lower_varorder_pq_.empty()) return 0;
+    var_t lower_nonzero_var() { return lower_levels_.pop_min(); }
 
-        uint16_t next = lower_varorder_pq_.top();
-        lower_varorder_pq_.pop();
-        return next;
+    /**
+     * @brief 计算n个节点、num_var个变量时各数组在Arena中占用的字节数。
+     */
+    static size_t arena_size(size_t n, int num_var) {
+        return 3 * arena_bytes<index_t>(num_var + 1) +
+               arena_bytes<index_t>(n) + 2 * arena_bytes<count_t>(n);
+    }
 
-        return 0;
+    /**
+     * @brief 各数组实际占用的字节数（按容量计算）。
+     * @return (名称, 字节数) 的列表。
+     */
+    std::vector<std::pair<const char *, size_t>> footprint() const {
+        return {
+            {"dp table elems", table_elems_.capacity() * sizeof(index_t)},
+            {"dp var heads", (var_heads_.capacity() + num_elems_.capacity()) *
+                                 sizeof(index_t)},
+            {"dp diff counters",
+             (diff_counter_.capacity() + diff_counter_hi_.capacity()) *
+                 sizeof(count_t)},
+        };
     }
 
     /**
-     * 将变量加入上方向优先队列。
+     * 将变量加入上方向的待处理层。
      * @param var 变量编号。
      */
-    void add_upper_var(uint16_t var) { upper_varorder_pq_.push(var); }
+    void add_upper_var(var_t var) { upper_levels_.insert(var); }
 
     /**
-     * 将变量加入下方向优先队列。
+     * 将变量加入下方向的待处理层。
      * @param var 变量编号。
      */
-    void add_lower_var(uint16_t var) { lower_varorder_pq_.push(var); }
+    void add_lower_var(var_t var) { lower_levels_.insert(var); }
 
 
    private:
-    std::vector<int32_t> table_elems_;// 存储表格元素的向量
-    std::vector<int32_t> var_heads_;// 存储变量头部索引的向量
-    std::vector<int32_t> num_elems_;// 存储每个变量元素数量的向量
-    std::vector<count_t> diff_counter_;// 存储节点差异计数的向量
-    std::vector<count_t> diff_counter_hi_;// 存储节点高分支差异计数的向量
+    arena_vector<index_t> table_elems_;// 存储表格元素的向量
+    arena_vector<index_t> var_heads_;// 存储变量头部索引的向量
+    arena_vector<index_t> num_elems_;// 存储每个变量元素数量的向量
+    arena_vector<count_t> diff_counter_;// 存储节点差异计数的向量
+    arena_vector<count_t> diff_counter_hi_;// 存储节点高分支差异计数的向量
 
     uint32_t entries_counter_;// 记录条目计数器
-    const uint16_t num_var_;// 变量数量
+    const var_t num_var_;// 变量数量
     int var_cache_;// 变量缓存
-    // 下方向优先队列，按升序排列
-    std::priority_queue<uint16_t, std::vector<uint16_t>, std::greater<uint16_t>>
-        lower_varorder_pq_;
-    // 上方向优先队列，按降序排列
-    std::priority_queue<uint16_t> upper_varorder_pq_;
+    LevelBitmap<var_t> lower_levels_;  // 下方向待处理层，按升序取出
+    LevelBitmap<var_t> upper_levels_;  // 上方向待处理层，按降序取出
 };
 
+extern template class DpManager<ZddTraits<uint32_t, int32_t, uint16_t>>;
+extern template class DpManager<ZddTraits<uint32_t, int32_t, uint32_t>>;
+extern template class DpManager<ZddTraits<uint32_t, int64_t, uint16_t>>;
+extern template class DpManager<ZddTraits<uint32_t, int64_t, uint32_t>>;
+extern template class DpManager<ZddTraits<uint64_t, int32_t, uint16_t>>;
+extern template class DpManager<ZddTraits<uint64_t, int32_t, uint32_t>>;
+extern template class DpManager<ZddTraits<uint64_t, int64_t, uint16_t>>;
+extern template class DpManager<ZddTraits<uint64_t, int64_t, uint32_t>>;
+extern template class DpManager<ZddTraits<count128_t, int32_t, uint16_t>>;
+extern template class DpManager<ZddTraits<count128_t, int32_t, uint32_t>>;
+extern template class DpManager<ZddTraits<count128_t, int64_t, uint16_t>>;
+extern template class DpManager<ZddTraits<count128_t, int64_t, uint32_t>>;
+
 #endif  // DP_MANAGER_H_
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include "frontier.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#include "unique_table.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * frontier-based search over the vertices of a graph.
+ * 按顶点顺序进行的基于前沿的搜索。
+ */
+class FrontierSearch {
+   public:
+    FrontierSearch(const Graph &graph, FrontierKind kind, size_t min_size,
+                   size_t max_size)
+        : kind_(kind),
+          min_size_(min_size),
+          max_size_(max_size),
+          n_(graph.vertices.size()),
+          lower_neighbors_(n_),
+          last_neighbor_(n_, -1),
+          frontiers_(n_ + 1) {
+        for (const auto &[u, v] : graph.edges) {
+            const uint32_t a = min(u, v), b = max(u, v);
+            lower_neighbors_[b].push_back(a);
+            last_neighbor_[a] = max<int64_t>(last_neighbor_[a], b);
+            last_neighbor_[b] = max<int64_t>(last_neighbor_[b], a);
+        }
+        // frontiers_[i]: 决定顶点 0..i-1 之后仍有未决定邻居的顶点
+        for (size_t i = 0; i < n_; i++) {
+            for (uint32_t v : frontiers_[i]) {
+                if (last_neighbor_[v] > (int64_t)i) frontiers_[i + 1].push_back(v);
+            }
+            if (last_neighbor_[i] > (int64_t)i) frontiers_[i + 1].push_back(i);
+            // 连通分量的编号为1字节
+            if (frontiers_[i + 1].size() >= 255) {
+                cerr << "frontier of " << frontiers_[i + 1].size()
+                     << " vertices is too wide" << endl;
+                exit(1);
+            }
+        }
+        size_cap_ = max_size_ < n_ ? max_size_ : max<size_t>(min_size_, 1);
+    }
+
+    /**
+     * @brief 构建约简的ZDD。
+     */
+    RawZdd build() {
+        // 各层节点的子节点：下一层中的下标或终端
+        vector<vector<pair<int64_t, int64_t>>> children(n_);
+        vector<string> states{encode(0, {}, {})};
+        for (size_t i = 0; i < n_; i++) {
+            unordered_map<string, int64_t> next_ids;
+            vector<string> next_states;
+            children[i].resize(states.size());
+            for (size_t k = 0; k < states.size(); k++) {
+                for (int x = 0; x < 2; x++) {
+                    string next;
+                    int64_t child = transit(i, states[k], x, next);
+                    if (child == NEXT_STATE) {
+                        auto it = next_ids.emplace(next, next_states.size());
+                        if (it.second) next_states.push_back(move(next));
+                        child = it.first->second;
+                    }
+                    (x ? children[i][k].second : children[i][k].first) = child;
+                }
+            }
+            states.swap(next_states);
+        }
+
+        // 自下而上约简
+        RawZdd zdd;
+        zdd.num_var = n_;
+        UniqueTable table(zdd.nodes);
+        vector<int64_t> reduced, upper;
+        for (size_t i = n_; i-- > 0;) {
+            upper.resize(children[i].size());
+            for (size_t k = 0; k < children[i].size(); k++) {
+                auto [lo, hi] = children[i][k];
+                if (lo >= 0) lo = reduced[lo];
+                if (hi >= 0) hi = reduced[hi];
+                upper[k] = table.get(i + 1, lo, hi);
+            }
+            reduced.swap(upper);
+            vector<pair<int64_t, int64_t>>().swap(children[i]);
+        }
+        if (reduced.empty() || reduced[0] < 0) {
+            // 没有选项，或只有空集
+            zdd.nodes.clear();
+            return zdd;
+        }
+        sort_nodes_by_var(zdd);
+        return zdd;
+    }
+
+   private:
+    static constexpr int64_t NEXT_STATE = 0;
+
+    // 状态：已选择的顶点数（上限为 size_cap_），前沿中各顶点的连通分量（0为未选择）和度数
+    string encode(size_t size, const vector<uint8_t> &comp,
+                  const vector<uint8_t> &deg) const {
+        string key(sizeof(uint32_t), '\0');
+        const uint32_t s = min(size, size_cap_);
+        memcpy(&key[0], &s, sizeof(s));
+        key.append(comp.begin(), comp.end());
+        if (kind_ != FrontierKind::Component) key.append(deg.begin(), deg.end());
+        return key;
+    }
+
+    /**
+     * @brief 在状态 key 下决定顶点 i 是否选择。
+     * @param x 1为选择。
+     * @param next 转移到下一个状态时输出其编码。
+     * @return 终端（DD_ONE_TERM / DD_ZERO_TERM），或 NEXT_STATE。
+     */
+    int64_t transit(size_t i, const string &key, int x, string &next) const {
+        const vector<uint32_t> &frontier = frontiers_[i];
+        const size_t w = frontier.size();
+        uint32_t stored_size;
+        memcpy(&stored_size, key.data(), sizeof(stored_size));
+        size_t size = stored_size;
+        vector<uint8_t> comp(key.begin() + 4, key.begin() + 4 + w);
+        vector<uint8_t> deg(w, 0);
+        if (kind_ != FrontierKind::Component) {
+            deg.assign(key.begin() + 4 + w, key.begin() + 4 + 2 * w);
+        }
+        // 顶点 i 加在最后
+        comp.push_back(0);
+        deg.push_back(0);
+        if (x) {
+            if (++size > max_size_) return DD_ZERO_TERM;
+            uint8_t label = 0;
+            for (uint8_t c : comp) label = max(label, c);
+            comp[w] = label + 1;
+            for (uint32_t j : lower_neighbors_[i]) {
+                const size_t p =
+                    lower_bound(frontier.begin(), frontier.end(), j) -
+                    frontier.begin();
+                if (comp[p] == 0) continue;
+                if (kind_ != FrontierKind::Component &&
+                    (++deg[p] > 2 || ++deg[w] > 2)) {
+                    return DD_ZERO_TERM;
+                }
+                if (comp[p] == comp[w]) {
+                    // 环：路径中不允许
+                    if (kind_ == FrontierKind::Path) return DD_ZERO_TERM;
+                    continue;
+                }
+                const uint8_t from = comp[p], to = comp[w];
+                for (uint8_t &c : comp) {
+                    if (c == from) c = to;
+                }
+            }
+        }
+
+        // 没有未决定的邻居的顶点离开前沿
+        vector<uint8_t> leaving;
+        vector<uint8_t> next_comp, next_deg;
+        for (size_t p = 0; p <= w; p++) {
+            const uint32_t v = p < w ? frontier[p] : i;
+            if (last_neighbor_[v] > (int64_t)i) {
+                next_comp.push_back(comp[p]);
+                next_deg.push_back(deg[p]);
+            } else if (comp[p] != 0) {
+                if (kind_ == FrontierKind::Cycle && deg[p] != 2) {
+                    return DD_ZERO_TERM;
+                }
+                leaving.push_back(comp[p]);
+            }
+        }
+        for (uint8_t c : leaving) {
+            if (find(next_comp.begin(), next_comp.end(), c) != next_comp.end()) {
+                continue;
+            }
+            // 连通分量已完整，其余顶点都不能再选择
+            for (uint8_t d : next_comp) {
+                if (d != 0 && d != c) return DD_ZERO_TERM;
+            }
+            for (uint8_t d : leaving) {
+                if (d != c) return DD_ZERO_TERM;
+            }
+            return size >= min_size_ ? DD_ONE_TERM : DD_ZERO_TERM;
+        }
+        if (i + 1 == n_) return DD_ZERO_TERM;
+
+        // 连通分量按首次出现的顺序重新编号
+        uint8_t relabel[256] = {0};
+        uint8_t num_labels = 0;
+        for (uint8_t &c : next_comp) {
+            if (c == 0) continue;
+            if (relabel[c] == 0) relabel[c] = ++num_labels;
+            c = relabel[c];
+        }
+        next = encode(size, next_comp, next_deg);
+        return NEXT_STATE;
+    }
+
+    const FrontierKind kind_;
+    const size_t min_size_;
+    const size_t max_size_;
+    const size_t n_;
+    size_t size_cap_;
+    // 顶点编号比自己小的邻居
+    vector<vector<uint32_t>> lower_neighbors_;
+    // 编号最大的邻居，没有邻居时为-1
+    vector<int64_t> last_neighbor_;
+    vector<vector<uint32_t>> frontiers_;
+};
+
+}  // namespace
+
+Graph read_edge_list(const string &file_name) {
+    ifstream ifs(file_name);
+    if (!ifs) {
+        cerr << "can't open " << file_name << endl;
+        exit(1);
+    }
+    Graph graph;
+    unordered_map<string, uint32_t> ids;
+    auto vertex_id = [&](const string &name) {
+        auto it = ids.emplace(name, graph.vertices.size());
+        if (it.second) graph.vertices.push_back(name);
+        return it.first->second;
+    };
+    string line, u, v, rest;
+    size_t line_no = 0;
+    while (getline(ifs, line)) {
+        line_no++;
+        istringstream iss(line);
+        if (!(iss >> u) || u[0] == '#') continue;
+        if (!(iss >> v)) {
+            vertex_id(u);
+            continue;
+        }
+        if ((iss >> rest) || u == v) {
+            cerr << file_name << ":" << line_no << ": invalid edge" << endl;
+            exit(1);
+        }
+        const uint32_t a = vertex_id(u), b = vertex_id(v);
+        graph.edges.emplace_back(min(a, b), max(a, b));
+    }
+    sort(graph.edges.begin(), graph.edges.end());
+    graph.edges.erase(unique(graph.edges.begin(), graph.edges.end()),
+                      graph.edges.end());
+    return graph;
+}
+
+RawZdd build_frontier_zdd(const Graph &graph, FrontierKind kind,
+                          size_t min_size, size_t max_size) {
+    return FrontierSearch(graph, kind, min_size, max_size).build();
+}
@@ -0,0 +1,56 @@
+#ifndef FRONTIER_H_
+#define FRONTIER_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "raw_zdd.h"
+
+/**
+ * An undirected simple graph read from an edge list.
+ * Each line is either "u v" (an edge) or "v" (a vertex without edges, or a
+ * vertex placed early in the order); lines starting with '#' are comments.
+ * Vertices are numbered in the order they first appear, which is also the
+ * variable order of the built ZDD (vertex i is var i + 1).
+ * 从边列表读取的无向简单图。每行为一条边"u v"或一个顶点"v"，以'#'开头的行为注释。
+ * 顶点按首次出现的顺序编号，也是构建的ZDD的变量顺序。
+ */
+struct Graph {
+    std::vector<std::string> vertices;
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+};
+
+/**
+ * kinds of vertex subsets enumerated by build_frontier_zdd.
+ * @attr Component: the induced subgraph is connected.
+ * @attr Path: the induced subgraph is a path.
+ * @attr Cycle: the induced subgraph is a cycle.
+ * 枚举的顶点子集的种类：诱导子图连通、为路径或为环。
+ */
+enum class FrontierKind { Component, Path, Cycle };
+
+/**
+ * @brief 读取边列表文件。
+ * @param file_name 边列表文件名。
+ * @return 读取的图。自环和多于两个顶点的行报错并退出，重复的边只保留一条。
+ */
+Graph read_edge_list(const std::string &file_name);
+
+/**
+ * @brief 以基于前沿的方法构建选项ZDD：选项为诱导子图满足 kind 的顶点集合。
+ * @param graph 图，项目为其顶点。
+ * @param kind 诱导子图须满足的条件。
+ * @param min_size 选项的最少顶点数。
+ * @param max_size 选项的最多顶点数。
+ * @return 按Graphillion输出的顺序排列的ZDD，可直接传给 ZddWithLinks::load_zdd。
+ * @details 按顶点顺序逐个决定是否选择。状态只保存前沿（已决定且还有未决定的邻居的顶点）
+ *          中各顶点所属的连通分量和度数，以及已选择的顶点数；相同的状态合并为一个节点。
+ *          一个连通分量离开前沿时选项即已确定，其余顶点都不选择。
+ *          最后自下而上经唯一表约简。
+ */
+RawZdd build_frontier_zdd(const Graph &graph, FrontierKind kind,
+                          size_t min_size, size_t max_size);
+
+#endif  // FRONTIER_H_
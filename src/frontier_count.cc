@@ -0,0 +1,114 @@
+#include "frontier_count.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+using namespace std;
+
+FrontierCounter::FrontierCounter(const RawZdd &zdd)
+    : zdd_(zdd),
+      start_(zdd.num_var + 2, -1),
+      slot_(zdd.num_var + 2, -1),
+      secondary_(zdd.num_var + 2, false) {
+    const vector<RawNode> &nodes = zdd.nodes;
+    const uint32_t n = zdd.num_var;
+    for (const uint32_t col : zdd.secondary) {
+        if (col <= n) secondary_[col] = true;
+    }
+    if (nodes.empty()) return;
+    for (int64_t id = nodes.size() - 1; id >= 0; id = nodes[id].lo) {
+        start_[nodes[id].var] = id;
+    }
+
+    // first[x]: 经过节点x的选项在x之前已选择的最小列，lo链上的节点为无穷大
+    const uint32_t inf = numeric_limits<uint32_t>::max();
+    vector<uint32_t> first(nodes.size(), inf);
+    // earliest[d]: 包含列d的选项中最小的开始列
+    vector<uint32_t> earliest(n + 2, inf);
+    // 父节点在子节点之后，因此从后向前传播
+    for (size_t id = nodes.size(); id-- > 0;) {
+        const RawNode &node = nodes[id];
+        const uint32_t begin = min(first[id], node.var);
+        earliest[node.var] = min(earliest[node.var], begin);
+        if (node.hi >= 0) first[node.hi] = min(first[node.hi], begin);
+        if (node.lo >= 0) first[node.lo] = min(first[node.lo], first[id]);
+    }
+
+    // 列d在 (earliest[d], d] 中处于前沿，对区间贪心分配位，
+    // 所用的位数等于同时处于前沿的列数的最大值
+    vector<vector<uint32_t>> entering(n + 2);
+    for (uint32_t d = 1; d <= n; d++) {
+        if (earliest[d] < d) entering[earliest[d] + 1].push_back(d);
+    }
+    vector<int> free_slots;
+    for (uint32_t c = 1; c <= n; c++) {
+        if (slot_[c - 1] >= 0) free_slots.push_back(slot_[c - 1]);
+        for (const uint32_t d : entering[c]) {
+            if (free_slots.empty()) free_slots.push_back(width_++);
+            slot_[d] = free_slots.back();
+            free_slots.pop_back();
+        }
+    }
+}
+
+/**
+ * @brief 把count加到sum，超过128位时报错退出。
+ */
+static void add_count(count128_t &sum, count128_t count) {
+    if (__builtin_add_overflow(sum, count, &sum)) {
+        cerr << "error: number of solutions exceeds 128 bits" << endl;
+        exit(1);
+    }
+}
+
+count128_t FrontierCounter::count() {
+    const vector<RawNode> &nodes = zdd_.nodes;
+    unordered_map<uint64_t, count128_t> states, next_states;
+    states.emplace(0, 1);
+    // 选择选项时待处理的 (节点, 状态)，按节点id降序（父节点先）处理
+    map<int64_t, unordered_map<uint64_t, count128_t>> pending;
+    auto push = [&](int64_t id, uint64_t state, count128_t count) {
+        if (id == DD_ONE_TERM) {
+            add_count(next_states[state], count);
+        } else if (id >= 0) {
+            add_count(pending[id][state], count);
+        }
+    };
+
+    for (uint32_t c = 1; c <= (uint32_t)zdd_.num_var && !states.empty(); c++) {
+        max_states_ = max(max_states_, states.size());
+        next_states.clear();
+        const uint64_t bit = slot_[c] >= 0 ? uint64_t(1) << slot_[c] : 0;
+        const int64_t start = start_[c];
+        for (const auto &[state, count] : states) {
+            if (state & bit) {
+                // 已被之前的选项覆盖
+                add_count(next_states[state & ~bit], count);
+            } else {
+                // 选择以c为最小列的选项
+                if (start >= 0) push(nodes[start].hi, state, count);
+                // 次要列可以不被覆盖
+                if (secondary_[c]) add_count(next_states[state], count);
+            }
+        }
+        while (!pending.empty()) {
+            auto it = prev(pending.end());
+            const int64_t id = it->first;
+            const unordered_map<uint64_t, count128_t> node_states =
+                move(it->second);
+            pending.erase(it);
+            const RawNode &node = nodes[id];
+            const uint64_t var_bit = uint64_t(1) << slot_[node.var];
+            for (const auto &[state, count] : node_states) {
+                if (!(state & var_bit)) push(node.hi, state | var_bit, count);
+                push(node.lo, state, count);
+            }
+        }
+        states.swap(next_states);
+    }
+    auto it = states.find(0);
+    return it == states.end() ? 0 : it->second;
+}
@@ -0,0 +1,64 @@
+#ifndef FRONTIER_COUNT_H_
+#define FRONTIER_COUNT_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "raw_zdd.h"
+
+/**
+ * Counting exact covers by dynamic programming over the columns in variable
+ * order, an alternative to the search for inputs of small frontier width.
+ * Column c is decided when it is reached: either it is already covered by an
+ * option chosen at an earlier column, or an option whose smallest column is c
+ * is chosen now by walking the ZDD below the hi edge of the node of c on the
+ * lo chain of the root. The state is the set of covered columns larger than
+ * c that some option starting at or before c can contain (the frontier);
+ * equal states are merged and their counts added. A secondary column may also
+ * be left uncovered.
+ * 按变量顺序逐列进行动态规划来计数精确覆盖，是前沿宽度较小的输入的搜索的替代。
+ * 到达列c时：c已被之前的列选择的选项覆盖，或者选择以c为最小列的选项，
+ * 即沿根节点lo链上c的节点的hi边在ZDD中走下去。状态为大于c的列中已覆盖的列的集合，
+ * 只包含以不大于c的列开始的选项可能包含的列（前沿）；相同的状态合并，计数相加。
+ * 次要列也可以不被覆盖。
+ */
+class FrontierCounter {
+   public:
+    /**
+     * @param zdd 约简的ZDD（见 reduce_zdd），按Graphillion输出的顺序排列。
+     *            有次要列时须不含只包含次要列的选项（见 remove_secondary_only_options）。
+     * @details 只计算前沿的宽度并为前沿的列分配状态中的位，不进行计数。
+     */
+    explicit FrontierCounter(const RawZdd &zdd);
+
+    /**
+     * @brief 前沿的最大列数，即状态的位数。状态数不超过 2 的该次方。
+     * @details 列d从以小于d的列开始的选项中最小的开始列之后到d为止在前沿中，
+     *          前沿的宽度是同时在前沿中的列数的最大值。
+     */
+    size_t width() const { return width_; }
+
+    /**
+     * @brief 计算精确覆盖的数量。
+     * @details 宽度须不超过64。计数以128位相加，超过128位时报错退出。
+     */
+    count128_t count();
+
+    /**
+     * @brief count 中一列的状态数的最大值。
+     */
+    size_t max_states() const { return max_states_; }
+
+   private:
+    const RawZdd &zdd_;
+    // start_[c]: 根节点lo链上var为c的节点，不存在时为-1
+    std::vector<int64_t> start_;
+    // slot_[c]: 列c在状态中的位，不在前沿中的列为-1
+    std::vector<int> slot_;
+    // secondary_[c]: 列c为次要列
+    std::vector<bool> secondary_;
+    size_t width_ = 0;
+    size_t max_states_ = 0;
+};
+
+#endif  // FRONTIER_COUNT_H_
@@ -1,4 +1,8 @@
 #include "hidden_node_stack.h"
 
-HiddenNodeStack::HiddenNodeStack(): 
-node_stack_(), stack_start_positions_() {}
\ No newline at end of file
+template <typename Index>
+HiddenNodeStack<Index>::HiddenNodeStack()
+    : node_stack_(), stack_start_positions_() {}
+
+template class HiddenNodeStack<int32_t>;
+template class HiddenNodeStack<int64_t>;
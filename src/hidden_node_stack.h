@@ -6,38 +6,78 @@
 #include <cstdint>
 #include <stack>
 #include <vector>
+
+#include "arena.h"
 /**
  * A stack storing the node cells to hide.
  * this class helps to restore hidden nodes in an appropriate order.
  * 该类用于存储需要隐藏的节点，并帮助按适当顺序恢复这些节点
+ * @tparam Index 节点单元id的类型。
  */
 
+template <typename Index>
 class HiddenNodeStack {
    public:
     // 表示隐藏节点的不同类型
     enum class HideType { UpperZero, LowerZero, CoverUp, CoverDown };
     // 栈中存储的值类型，包含节点 ID 和隐藏类型
-    using stack_value_t = std::pair<int32_t, HideType>;
+    using stack_value_t = std::pair<Index, HideType>;
 
     // 构造函数，初始化隐藏节点栈
     HiddenNodeStack();
 
+    /**
+     * @brief 预先分配栈的空间。
+     * @param n 最大元素数。隐藏中的节点不会再次被隐藏，因此节点数即为上限。
+     * @param arena 分配的Arena，nullptr 时使用堆。
+     */
+    void reserve(size_t n, Arena *arena) {
+        node_stack_ = arena_vector<stack_value_t>(
+            ArenaAllocator<stack_value_t>(arena));
+        node_stack_.reserve(n);
+    }
+
+    /**
+     * @brief 计算n个元素在Arena中占用的字节数。
+     */
+    static size_t arena_size(size_t n) {
+        return arena_bytes<stack_value_t>(n);
+    }
+
+    /**
+     * @brief 栈实际占用的字节数（按容量计算）。
+     */
+    size_t footprint() const {
+        return node_stack_.capacity() * sizeof(stack_value_t);
+    }
+
     // 获取栈顶元素
     // 返回栈顶的节点ID和类型
     stack_value_t top() const { return *node_stack_.crbegin(); }
 
     // 移除栈顶元素
-    void pop() { node_stack_.pop_back(); }
+    void pop() {
+        if (node_stack_.back().second == HideType::CoverUp) num_cover_up_--;
+        node_stack_.pop_back();
+    }
+
+    /**
+     * @brief 当前隐藏的节点数。
+     * @details 被覆盖的列的节点各有一个 CoverDown 和一个 CoverUp 元素，
+     *          因此不计 CoverUp 的元素。
+     */
+    size_t num_hidden() const { return node_stack_.size() - num_cover_up_; }
 
     // 将 CoverDown 类型的节点压栈
     // 输入需要隐藏的节点的ID
-    void push_cover_down(const int32_t val) {
+    void push_cover_down(const Index val) {
         node_stack_.emplace_back(val, HideType::CoverDown);
     }
 
     // 将 CoverUp 类型的节点压入栈
     // 输入隐藏节点的ID
-    void push_cover_up(const int32_t val) {
+    void push_cover_up(const Index val) {
+        num_cover_up_++;
         node_stack_.emplace_back(val, HideType::CoverUp);
     }
 
@@ -45,13 +85,13 @@ class HiddenNodeStack {
     * @brief 将 UpperZero 类型的隐藏节点压入栈。
     * @param val 需要隐藏的节点 ID。
     */
-    void push_upperzero(const int32_t val) {
+    void push_upperzero(const Index val) {
         node_stack_.emplace_back(val, HideType::UpperZero);
     }
 
     // 将 LowerZero 类型的隐藏节点压入栈。
     // param val 需要隐藏的节点 ID。
-    void push_lowerzero(const int32_t val) {
+    void push_lowerzero(const Index val) {
         node_stack_.emplace_back(val, HideType::LowerZero);
     }
 
@@ -80,7 +120,7 @@ class HiddenNodeStack {
     * @brief 获取当前栈段的起始迭代器。
      * @return 返回常量迭代器，指向当前栈段的开始。
      */
-    std::vector<stack_value_t>::const_iterator stack_cbegin() const {
+    typename arena_vector<stack_value_t>::const_iterator stack_cbegin() const {
         return node_stack_.cbegin() + stack_start_positions_.top();
     }
 
@@ -88,7 +128,7 @@ class HiddenNodeStack {
     * @brief 获取当前栈段的结束迭代器。
     * @return 返回常量迭代器，指向当前栈段的结束。
     */
-    std::vector<stack_value_t>::const_iterator stack_cend() const {
+    typename arena_vector<stack_value_t>::const_iterator stack_cend() const {
         return node_stack_.cend();
     }
 
@@ -102,8 +142,12 @@ class HiddenNodeStack {
     }
 
    private:
-    std::vector<stack_value_t> node_stack_; // 存储隐藏的节点及其类型
-    std::stack<int32_t, std::vector<int32_t>> stack_start_positions_;// 记录检查点位置
+    arena_vector<stack_value_t> node_stack_; // 存储隐藏的节点及其类型
+    std::stack<size_t, std::vector<size_t>> stack_start_positions_;// 记录检查点位置
+    size_t num_cover_up_ = 0;  // 栈中 CoverUp 元素的数量
 };
 
+extern template class HiddenNodeStack<int32_t>;
+extern template class HiddenNodeStack<int64_t>;
+
 #endif  // HIDDEN_NODE_STACK_H_
\ No newline at end of file
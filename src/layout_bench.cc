@@ -0,0 +1,219 @@
+// cache-miss microbenchmark of the layout of node cells
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "cache_miss_counter.h"
+#include "dancing_on_zdd.h"
+#include "raw_zdd.h"
+
+using Traits = ZddTraits<uint64_t, int32_t, uint16_t>;
+using index_t = Traits::index_t;
+using plink_t = Traits::plink_t;
+
+/**
+ * 测量结果：最好的一次的时间和对应的缓存未命中数。
+ */
+struct Measure {
+    double msecs = 1e300;
+    uint64_t misses = 0;
+    uint64_t accesses = 0;
+};
+
+/**
+ * 向下扫描：从起点沿hi/lo边走到终端，读写 batch_cover 向下扫描使用的字段（计数、var）
+ * @param table 节点单元表（Node的数组或NodeTable）。
+ * @param starts 各次扫描的起点。
+ * @return 访问的节点单元数。
+ */
+template <typename Table>
+uint64_t sweep_down(Table &table, const vector<index_t> &starts) {
+    uint64_t accesses = 0;
+    for (const index_t start : starts) {
+        for (index_t id = start; id >= 0; accesses++) {
+            auto &&node = table[id];
+            node.count_upper += node.var;
+            id = (node.count_upper & 1) ? node.hi : node.lo;
+        }
+    }
+    return accesses;
+}
+
+/**
+ * 向上扫描：从起点沿父链接走到根节点，读取向上扫描使用的父链接和计数
+ * @param table 节点单元表（Node的数组或NodeTable）。
+ * @param starts 各次扫描的起点。
+ * @return 访问的节点单元数。
+ */
+template <typename Table>
+uint64_t sweep_up(Table &table, const vector<index_t> &starts) {
+    uint64_t accesses = 0;
+    for (const index_t start : starts) {
+        for (plink_t link = start + 1; link != 0; accesses++) {
+            auto &&node = table[link - 1];
+            node.count_hi += 1;
+            link = (node.count_hi & 1) ? node.parents_head : node.hi_next;
+        }
+    }
+    return accesses;
+}
+
+/**
+ * 重复执行扫描，记录最好的一次
+ */
+template <typename F>
+Measure measure(F &&sweep, int repeats) {
+    using clock = std::chrono::steady_clock;
+    CacheMissCounter counter;
+    Measure best;
+    for (int r = 0; r < repeats; r++) {
+        counter.start();
+        const auto t0 = clock::now();
+        const uint64_t accesses = sweep();
+        const auto t1 = clock::now();
+        const uint64_t misses = counter.stop();
+        const double msecs =
+            std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if (msecs < best.msecs) best = {msecs, misses, accesses};
+    }
+    return best;
+}
+
+void print_measure(const char *layout, const char *sweep, const Measure &m,
+                   bool available) {
+    printf("  %-9s %-5s %9.1f msecs, %6.2f ns/access", layout, sweep, m.msecs,
+           m.msecs * 1e6 / m.accesses);
+    if (available) {
+        printf(", %.3f misses/access\n", (double)m.misses / m.accesses);
+    } else {
+        printf(", cache misses unavailable\n");
+    }
+}
+
+/**
+ * 以相同的节点结构建立Node的数组（AoS）和NodeTable（hot/cold拆分），
+ * 比较向下扫描和向上扫描的缓存未命中数和时间。
+ * 节点单元按var降序排列时子节点在后、父节点在前，hi/lo指向之后的随机节点，
+ * 父链接指向之前的随机节点，因此每次扫描约访问 ln(节点数) 个分散的节点单元。
+ * 给定ZDD文件时使用其hi/lo结构，父链接为各节点的一个父节点。
+ * usage: ./layout_bench [-n repeats] [-s nodes] [zdd_file...]
+ */
+int main(int argc, char **argv) {
+    int repeats = 3;
+    vector<size_t> sizes;
+    vector<string> files;
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            repeats = atoi(argv[++i]);
+        } else if (arg == "-s" && i + 1 < argc) {
+            sizes.push_back(strtoull(argv[++i], nullptr, 10));
+        } else if (arg[0] == '-') {
+            cerr << "usage: ./layout_bench [-n repeats] [-s nodes] "
+                    "[zdd_file...]"
+                 << endl;
+            exit(1);
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (sizes.empty() && files.empty()) {
+        sizes = {size_t(1) << 16, size_t(1) << 20, size_t(1) << 22};
+    }
+    const bool available = CacheMissCounter().available();
+    if (!available) {
+        printf("hardware cache-miss counter unavailable (perf_event_open "
+               "failed), comparing time only\n");
+    }
+    printf("sizeof(Node) = %zu, hot/links/up = %zu/%zu/%zu bytes\n",
+           sizeof(Node<Traits>), sizeof(NodeTable<Traits>::NodeHot),
+           sizeof(NodeTable<Traits>::NodeLinks), sizeof(index_t));
+
+    std::mt19937_64 rng(1);
+    auto run = [&](const string &name, const vector<RawNode> &nodes,
+                   const vector<int64_t> &parent) {
+        const size_t n = nodes.size();
+        vector<Node<Traits>> aos;
+        aos.reserve(n);
+        NodeTable<Traits> table;
+        table.reserve(n);
+        for (size_t id = 0; id < n; id++) {
+            const RawNode &raw = nodes[id];
+            aos.emplace_back((uint16_t)raw.var, (index_t)raw.hi,
+                             (index_t)raw.lo);
+            table.emplace_back((uint16_t)raw.var, (index_t)raw.hi,
+                               (index_t)raw.lo);
+            // 这里的父链接只存放 id + 1（0表示没有父节点），不使用标志位
+            const plink_t link = parent[id] < 0 ? 0 : parent[id] + 1;
+            aos.back().parents_head = link;
+            table[id].parents_head = link;
+            const int64_t other = parent[id] < 0 ? -1 : rng() % (id + 1);
+            const plink_t next = other < 0 || other == (int64_t)id
+                                     ? link
+                                     : (plink_t)other + 1;
+            aos.back().hi_next = next;
+            table[id].hi_next = next;
+        }
+        // 起点在节点单元中均匀分布，AoS和NodeTable使用相同的起点
+        vector<index_t> starts(std::max<size_t>(n, size_t(1) << 20));
+        for (index_t &s : starts) s = rng() % n;
+
+        printf("%s: %zu node cells, %zu sweeps\n", name.c_str(), n,
+               starts.size());
+        print_measure("AoS", "down",
+                      measure([&] { return sweep_down(aos, starts); },
+                              repeats),
+                      available);
+        print_measure("hot/cold", "down",
+                      measure([&] { return sweep_down(table, starts); },
+                              repeats),
+                      available);
+        print_measure("AoS", "up",
+                      measure([&] { return sweep_up(aos, starts); }, repeats),
+                      available);
+        print_measure("hot/cold", "up",
+                      measure([&] { return sweep_up(table, starts); },
+                              repeats),
+                      available);
+    };
+
+    for (const size_t n : sizes) {
+        vector<RawNode> nodes(n);
+        vector<int64_t> parent(n, -1);
+        for (size_t id = 0; id < n; id++) {
+            const size_t rest = n - id - 1;
+            nodes[id].var = std::min<size_t>(id + 1, 65535);
+            nodes[id].hi = rest ? (int64_t)(id + 1 + rng() % rest)
+                                : DD_ONE_TERM;
+            nodes[id].lo = rest ? (int64_t)(id + 1 + rng() % rest)
+                                : DD_ZERO_TERM;
+            if (id > 0) parent[id] = rng() % id;
+        }
+        run("synthetic", nodes, parent);
+    }
+    for (const string &file : files) {
+        RawZdd zdd = read_zdd_file(file);
+        reduce_zdd(zdd);
+        // 节点按var降序排列，根节点在最后；反转使父节点在前
+        const size_t n = zdd.nodes.size();
+        vector<RawNode> nodes(n);
+        auto flip = [&](int64_t id) {
+            return id < 0 ? id : (int64_t)(n - 1 - id);
+        };
+        for (size_t id = 0; id < n; id++) {
+            const RawNode &raw = zdd.nodes[n - 1 - id];
+            nodes[id] = {raw.var, flip(raw.hi), flip(raw.lo)};
+        }
+        vector<int64_t> parent(n, -1);
+        for (size_t id = 0; id < n; id++) {
+            for (const int64_t child : {nodes[id].hi, nodes[id].lo}) {
+                if (child >= 0 && parent[child] < 0) parent[child] = id;
+            }
+        }
+        run(file, nodes, parent);
+    }
+    return 0;
+}
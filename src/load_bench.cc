@@ -0,0 +1,56 @@
+// load-time benchmark of ZDD files
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "dancing_on_zdd.h"
+#include "dp_manager.h"
+#include "raw_zdd.h"
+
+/**
+ * 对每个ZDD文件分别测量读取（read_zdd_file）、约简（reduce_zdd）和建立舞动链接（load_zdd）的时间。
+ * usage: ./load_bench [-n repeats] zdd_file...
+ */
+int main(int argc, char **argv) {
+    int repeats = 3;
+    int first = 1;
+    if (argc > 2 && string(argv[1]) == "-n") {
+        repeats = atoi(argv[2]);
+        first = 3;
+    }
+    if (first >= argc) {
+        cerr << "usage: ./load_bench [-n repeats] zdd_file..." << endl;
+        exit(1);
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto msecs = [](clock::time_point s, clock::time_point e) {
+        return std::chrono::duration<double, std::milli>(e - s).count();
+    };
+    for (int f = first; f < argc; f++) {
+        double best_read = 1e300, best_reduce = 1e300, best_setup = 1e300;
+        size_t num_nodes = 0, num_removed = 0;
+        for (int r = 0; r < repeats; r++) {
+            const auto t0 = clock::now();
+            RawZdd zdd = read_zdd_file(argv[f]);
+            const auto t1 = clock::now();
+            num_removed = reduce_zdd(zdd);
+            const auto t2 = clock::now();
+            // 位宽固定为64位计数、64位节点id、32位变量编号，可以读取任意输入
+            ZddWithLinks<ZddTraits<uint64_t, int64_t, uint32_t>> zdd_with_links(
+                zdd.num_var);
+            zdd_with_links.load_zdd(zdd);
+            const auto t3 = clock::now();
+            best_read = min(best_read, msecs(t0, t1));
+            best_reduce = min(best_reduce, msecs(t1, t2));
+            best_setup = min(best_setup, msecs(t2, t3));
+            num_nodes = zdd.nodes.size();
+        }
+        printf("%s: %zu nodes (%zu removed), read %.1f msecs, reduce %.1f "
+               "msecs, setup %.1f msecs (best of %d)\n",
+               argv[f], num_nodes, num_removed, best_read, best_reduce,
+               best_setup, repeats);
+    }
+    return 0;
+}
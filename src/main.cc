@@ -1,11 +1,35 @@
 #include <math.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
+#include <fstream>
+#include <sstream>
 #include <unordered_set>
 
+#include "cache_miss_counter.h"
 #include "dancing_on_zdd.h"
 #include "dp_manager.h"
+#include "frontier.h"
+#include "frontier_count.h"
+#include "option_list.h"
+#include "raw_zdd.h"
+#include "snapshot.h"
+#include "zdd_algebra.h"
+
+// 连通分量解数缓存的键的字节数上限
+constexpr size_t COMPONENT_CACHE_BYTES = size_t(256) << 20;
+// 默认的进行重新压缩的存活节点单元的最大比例
+constexpr double DEFAULT_RECOMPRESS_RATIO = 0.5;
+// 默认的使用前沿动态规划计数的最大前沿宽度：每列至多 2^20 个状态，
+// 每个状态表（哈希表的节点约56字节）在60 MiB左右以内
+constexpr int DEFAULT_FRONTIER_WIDTH_LIMIT = 20;
+// 默认的把选项移出ZDD的私有节点数与列数之比的阈值（0表示不移出）
+constexpr double DEFAULT_SIDE_ROW_RATIO = 0.5;
+// 默认的移出ZDD的一组选项至少要有的私有节点数。更小的组省下的节点很少，
+// 却改变了分支列的选择顺序（只有行的列优先），反而增加更新次数
+constexpr size_t DEFAULT_SIDE_ROW_MIN_NODES = 4;
 
 /**
  * main function
@@ -19,98 +43,827 @@
 // extern uint64_t num_inactive_updates;
 
 /**
- * get number of variables from zdd file
- * 获取ZDD文件中的变量数
- * 输入文件路径
- * 返回变量数量
+ * options of a run
+ * @attr recompress_depth: search depth to recompress the residual ZDD, -1 if
+ * disabled.
+ * @attr recompress_ratio: the residual ZDD is extracted only when the live
+ * node cells are at most this ratio of all node cells.
+ * @attr decompose_interval: interval of search depths at which the residual
+ * problem is split into connected components, 0 for the root only, -1 if
+ * disabled.
+ * @attr count_cache_misses: report hardware cache misses of the search.
+ * @attr report_footprint: report the memory footprint of each structure.
+ * @attr parallel_level_threshold: minimum number of nodes of a level processed
+ * in parallel chunks, 0 if disabled.
+ * @attr parallel_setup_threshold: minimum number of node cells for setting up
+ * dancing links in parallel, 0 if always serial. -1 keeps the default.
+ * @attr verify_setup: compare the set-up structure with a serial setup.
+ * @attr snapshot_in: snapshot file to load instead of the ZDD file.
+ * @attr snapshot_out: write a snapshot to this file after loading and exit.
+ * @attr side_row_ratio: options whose private ZDD nodes reach this ratio of
+ * their cells are kept as plain rows besides the ZDD, 0 if disabled.
+ * @attr side_row_min_nodes: the least number of private nodes of the options
+ * of a column kept as plain rows.
+ * @attr frontier_width_limit: count by the frontier DP instead of the search
+ * when the frontier width is at most this, 0 if always searching.
+ * @attr frontier_width_given: -F is given on the command line.
+ * @attr layout_options: -c, -w, -C, -l or -P is given. They select the
+ * layout of the dancing links, so they only apply to the search.
+ * @attr query_file: file of queries answered on the loaded instance, "-" for
+ * stdin.
+ * @attr residual_prefix: with query_file, write the residual ZDD of query k to
+ * residual_prefix + k + ".zdd" instead of counting.
+ * 运行选项
  */
-int get_num_vars_from_zdd_file(const string& file_name) {
-    ifstream ifs(file_name);
+struct RunOptions {
+    string snapshot_in;
+    string snapshot_out;
+    int recompress_depth = -1;
+    double recompress_ratio = DEFAULT_RECOMPRESS_RATIO;
+    int decompose_interval = -1;
+    bool count_cache_misses = false;
+    bool report_footprint = false;
+    size_t parallel_level_threshold = 0;
+    long parallel_setup_threshold = -1;
+    bool verify_setup = false;
+    int frontier_width_limit = DEFAULT_FRONTIER_WIDTH_LIMIT;
+    bool frontier_width_given = false;
+    double side_row_ratio = DEFAULT_SIDE_ROW_RATIO;
+    size_t side_row_min_nodes = DEFAULT_SIDE_ROW_MIN_NODES;
+    string query_file;
+    string residual_prefix;
+    bool layout_options = false;
 
-    if (!ifs) {
-        cerr << "can't open " << file_name << endl;
-        exit(1);
+    // 是否指定了只对搜索有意义的选项
+    bool requires_search() const {
+        return !snapshot_out.empty() || recompress_depth >= 0 ||
+               decompose_interval >= 0 || count_cache_misses ||
+               report_footprint || parallel_level_threshold > 0 ||
+               verify_setup || !query_file.empty() || layout_options;
     }
+};
 
-    string line;
+// 显示用法并退出
+void show_help_and_exit() {
+    std::cerr << "usage: ./dancing_on_zdd_main (-z zdd_file... [-e expr] "
+                 "[-M mib] | -x option_file | "
+                 "-g graph_file [-k kind] [-n min:max] | -s snapshot) "
+                 "[-y secondary_file] [-b bounds_file] [-q query_file [-W prefix]] [-S snapshot] [-r depth[:ratio]] [-K interval] [-F width] [-R ratio[:nodes]] "
+                 "[-c bits] [-w] [-C] [-p] [-l] [-m] [-L nodes] [-P nodes] [-V]\n"
+              << "  -e expr: combine the -z inputs z1, z2, ... with | (union), "
+                 "& (intersection), - (difference), onset(e, item), "
+                 "offset(e, item) and restrict(e, e)\n"
+              << "  -M mib: memory budget of the operation cache of -e "
+                 "(default 512)\n"
+              << "  -x option_file: build the ZDD from options in the DLX "
+                 "format\n"
+              << "  -g graph_file: build the ZDD of vertex subsets of the graph "
+                 "in the edge list by frontier-based search\n"
+              << "  -k kind: induced subgraphs of -g options are connected "
+                 "(component, default), paths (path) or cycles (cycle)\n"
+              << "  -n min:max: number of vertices of -g options\n"
+              << "  -y secondary_file: columns covered at most once "
+                 "(default zdd_file.secondary if it exists)\n"
+              << "  -b bounds_file: lines \"column lower upper\" giving the "
+                 "number of times a column is covered (default zdd_file.bounds "
+                 "if it exists)\n"
+              << "  -q query_file: count the solutions under the assumptions "
+                 "of each line (column c, option +c,c,... or forbidden option "
+                 "-c,c,...) on the loaded instance, - for stdin\n"
+              << "  -W prefix: with -q, write the residual ZDD of query k to "
+                 "prefix<k>.zdd (with .map and .secondary) instead of "
+                 "counting\n"
+              << "  -s snapshot: load a snapshot written by -S instead of a "
+                 "ZDD file\n"
+              << "  -S snapshot: write a snapshot after loading and exit\n"
+              << "  -r depth[:ratio]: recompress the residual ZDD at the given "
+                 "search depth when its live node cells are at most ratio "
+                 "of all node cells (default 0.5)\n"
+              << "  -K interval: count the connected components of the "
+                 "residual problem separately at the root and every interval "
+                 "depths (0 for the root only)\n"
+              << "  -F width: count by dynamic programming over the columns "
+                 "instead of searching when the frontier width is at most "
+                 "width (default 20, at most 64, 0 to always search)\n"
+              << "  -R ratio[:nodes]: keep the options of a column as plain "
+                 "rows besides the ZDD when their private nodes reach ratio "
+                 "times their cells and at least nodes (default 0.5:4, 0 to "
+                 "disable)\n"
+              << "  -c bits: use at least the given count width (32, 64 or "
+                 "128)\n"
+              << "  -w: use 64-bit node ids and parent links\n"
+              << "  -C: use 32-bit variable (column) ids\n"
+              << "  -p: report hardware cache misses per update of the "
+                 "search\n"
+              << "  -l: renumber nodes for cache locality when loading\n"
+              << "  -m: report the memory footprint of each structure\n"
+              << "  -L nodes: process levels having at least the given "
+                 "number of nodes in parallel (needs OpenMP)\n"
+              << "  -P nodes: set up dancing links in parallel for ZDDs "
+                 "having at least the given number of nodes, 0 for serial "
+                 "(needs OpenMP)\n"
+              << "  -V: check that the setup equals a serial setup\n"
+              << std::endl;
+    exit(1);
+}
 
-    unordered_set<int> vars;
-    // 跳过以'.'开头的行、空行或长度为0的行
-    while (getline(ifs, line)) {
-        if (line[0] == '.' || line[0] == '\n' || line.size() == 0) continue;
+/**
+ * 读取ZDD文件，检查其结构并约简
+ * @param file_name ZDD文件名。
+ * @return 约简的ZDD。
+ */
+RawZdd read_reduced_zdd(const string& file_name) {
+    RawZdd zdd = read_zdd_file(file_name);
+    auto reduce_start_time = std::chrono::system_clock::now();
+    const size_t num_read = zdd.nodes.size();
+    const size_t num_removed = reduce_zdd(zdd);
+    fprintf(stderr, "reduced %s: removed %zu of %zu nodes (%lld msecs)\n",
+            file_name.c_str(), num_removed, num_read,
+            (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now() - reduce_start_time)
+                .count());
+    return zdd;
+}
 
-        istringstream iss(line);
-        int nid;
-        int var;
-        string lo_str;
-        int lo_id;
-        string hi_str;
-        int hi_id;
-        iss >> nid;// 读取节点ID
-        iss >> var;// 读取变量ID
+/**
+ * 把读取的覆盖次数上下界并入ZDD
+ * @param zdd ZDD，更新其 secondary 和 bounds。
+ * @param bounds 读取的上下界，按列升序。
+ * 下界为0的列为次要列；恰好一次和至多一次的上下界是默认值，不保存。
+ */
+void apply_column_bounds(RawZdd& zdd, const vector<ColumnBounds>& bounds) {
+    vector<ColumnBounds> merged;
+    auto it = zdd.bounds.begin();
+    for (const ColumnBounds& b : bounds) {
+        for (; it != zdd.bounds.end() && it->column < b.column; ++it) {
+            merged.push_back(*it);
+        }
+        if (it != zdd.bounds.end() && it->column == b.column) ++it;
+        merged.push_back(b);
+    }
+    merged.insert(merged.end(), it, zdd.bounds.end());
 
-        vars.emplace(var);
+    zdd.bounds.clear();
+    for (const ColumnBounds& b : merged) {
+        const bool secondary = binary_search(
+            zdd.secondary.begin(), zdd.secondary.end(), b.column);
+        if (secondary && b.lower > 0) {
+            fprintf(stderr, "secondary column %u has a positive lower bound\n",
+                    b.column);
+            exit(1);
+        }
+        if (b.lower == 0 && !secondary) {
+            zdd.secondary.insert(upper_bound(zdd.secondary.begin(),
+                                             zdd.secondary.end(), b.column),
+                                 b.column);
+        }
+        if (b.upper > 1 || b.lower > 1) zdd.bounds.push_back(b);
     }
+}
 
-    return vars.size();
+/**
+ * 前沿宽度足够小时以前沿动态规划计数并输出结果
+ * @param zdd 约简的ZDD。
+ * @param width_limit 最大前沿宽度。
+ * @return 进行了计数时返回 true，否则应进行搜索。
+ */
+bool count_by_frontier_dp(const RawZdd& zdd, int width_limit) {
+    FrontierCounter counter(zdd);
+    if (counter.width() > (size_t)width_limit) {
+        fprintf(stderr, "frontier width %zu, searching\n", counter.width());
+        return false;
+    }
+    auto start_time = std::chrono::system_clock::now();
+    const count128_t num_solutions = counter.count();
+    auto end_time = std::chrono::system_clock::now();
+    printf("frontier width %zu, max states %zu, num solutions %s, "
+           "time: %llu msecs\n",
+           counter.width(), counter.max_states(),
+           count_to_string(num_solutions).c_str(),
+           (unsigned long long)std::chrono::duration_cast<
+               std::chrono::milliseconds>(end_time - start_time)
+               .count());
+    return true;
 }
 
-// 显示用法并退出
-void show_help_and_exit() {
-    std::cerr << "usage: ./dancing_on_zdd_main -z zdd_file\n" << std::endl;
-    exit(1);
+/**
+ * 输出各数据结构的内存占用和Arena的使用情况
+ * @param zdd_with_links 搜索后的DanceDD。
+ */
+template <typename Traits>
+void report_footprint(const ZddWithLinks<Traits>& zdd_with_links) {
+    size_t total = 0;
+    for (const auto& [name, bytes] : zdd_with_links.footprint()) {
+        fprintf(stderr, "  %-26s %12zu bytes\n", name, bytes);
+        total += bytes;
+    }
+    fprintf(stderr, "  %-26s %12zu bytes\n", "total", total);
+    if (const Arena* arena = zdd_with_links.arena()) {
+        fprintf(stderr, "arena %zu / %zu bytes used, %s\n", arena->used(),
+                arena->capacity(),
+                arena->explicit_huge_pages()      ? "explicit 2MiB pages"
+                : arena->transparent_huge_pages() ? "MADV_HUGEPAGE"
+                                                  : "4KiB pages");
+    }
 }
 
-int main(int argc, char** argv) {
-    int opt;
-    string zdd_file_name;
-    int num_var = -1;
-    
-    // 解析命令行参数
-    while ((opt = getopt(argc, argv, "z:h")) != -1) {
-        switch (opt) {
-            case 'z':
-                zdd_file_name = optarg;// 读取 -z 参数之后的ZDD文件名
-                break;
-            case 'h':
-                show_help_and_exit();// 读取失败就显示用法
-                break;
+/**
+ * 解析查询的一行
+ * @param line 查询，空格分隔的列 c、强制的选项 +c,c,... 和禁止的选项 -c,c,...，
+ *             # 之后为注释。
+ * @param num_var 列数。
+ * @param assumptions 输出的假设，选项的列升序。
+ * @return 格式正确时返回 true。
+ */
+bool parse_query(const string& line, uint32_t num_var,
+                 Assumptions& assumptions) {
+    assumptions = Assumptions();
+    istringstream words(line.substr(0, line.find('#')));
+    string word;
+    while (words >> word) {
+        const char kind = word[0] == '+' || word[0] == '-' ? word[0] : 0;
+        vector<uint32_t> columns;
+        istringstream items(word.substr(kind ? 1 : 0));
+        string item;
+        while (getline(items, item, ',')) {
+            char* end;
+            const unsigned long col = strtoul(item.c_str(), &end, 10);
+            if (item.empty() || *end != '\0' || col == 0 || col > num_var) {
+                return false;
+            }
+            columns.push_back(col);
+        }
+        if (columns.empty() || (!kind && columns.size() > 1)) return false;
+        sort(columns.begin(), columns.end());
+        if (adjacent_find(columns.begin(), columns.end()) != columns.end()) {
+            return false;
+        }
+        if (kind == '+') {
+            assumptions.forced.push_back(columns);
+        } else if (kind == '-') {
+            assumptions.forbidden.push_back(columns);
+        } else {
+            assumptions.columns.push_back(columns[0]);
         }
     }
-    
-    // 如果未提供ZDD文件名，则显示用法并退出
-    if (zdd_file_name.empty()) {
-        show_help_and_exit();
+    return true;
+}
+
+/**
+ * 在已加载的DanceDD上逐行回答查询，每个查询输出一行
+ * @param zdd_with_links 已加载的DanceDD。
+ * @param num_var 列数。
+ * @param query_file 查询文件，"-" 为标准输入。
+ * @param residual_prefix 非空时不计数，把第k个查询的残余问题写入 residual_prefix<k>.zdd。
+ * @details 没有假设的行（空行和注释）被跳过。每个查询后结构恢复，不重新加载。
+ */
+template <typename Traits>
+void run_queries(ZddWithLinks<Traits>& zdd_with_links, uint32_t num_var,
+                 const string& query_file, const string& residual_prefix) {
+    ifstream file;
+    if (query_file != "-") {
+        file.open(query_file);
+        if (!file) {
+            fprintf(stderr, "can't open %s\n", query_file.c_str());
+            exit(1);
+        }
     }
-    
-    // 获取ZDD文件中的变量数
-    num_var = get_num_vars_from_zdd_file(zdd_file_name);
-    
-    // 创建ZDD结构，并从文件加载数据
-    ZddWithLinks zdd_with_links(num_var, false);
-    zdd_with_links.load_zdd_from_file(zdd_file_name);
-    
+    istream& in = query_file == "-" ? cin : file;
+    vector<vector<typename Traits::var_t>> solution;
+    Assumptions assumptions;
+    string line;
+    size_t num_queries = 0;
+    for (size_t line_no = 1; getline(in, line); line_no++) {
+        if (!parse_query(line, num_var, assumptions)) {
+            fprintf(stderr, "invalid query at line %zu: %s\n", line_no,
+                    line.c_str());
+            exit(1);
+        }
+        if (assumptions.columns.empty() && assumptions.forced.empty() &&
+            assumptions.forbidden.empty()) {
+            continue;
+        }
+        if (!residual_prefix.empty()) {
+            const string file_name =
+                residual_prefix + to_string(++num_queries) + ".zdd";
+            count128_t count;
+            if (zdd_with_links.write_residual_with_assumptions(
+                    assumptions, file_name, count)) {
+                printf("query %zu: residual written to %s\n", num_queries,
+                       file_name.c_str());
+            } else {
+                // 不需要搜索即可得到解数，不写入文件
+                printf("query %zu: num solutions %s\n", num_queries,
+                       count_to_string(count).c_str());
+            }
+            fflush(stdout);
+            continue;
+        }
+        ZddWithLinks<Traits>::num_search_tree_nodes = 0;
+        auto start_time = std::chrono::steady_clock::now();
+        const count128_t num_solutions =
+            zdd_with_links.count_with_assumptions(assumptions, solution);
+        auto end_time = std::chrono::steady_clock::now();
+        printf("query %zu: num nodes %llu, num solutions %s, time: %.3f "
+               "msecs\n",
+               ++num_queries,
+               (unsigned long long)ZddWithLinks<Traits>::num_search_tree_nodes,
+               count_to_string(num_solutions).c_str(),
+               std::chrono::duration<double, std::milli>(end_time - start_time)
+                   .count());
+        fflush(stdout);
+    }
+}
+
+/**
+ * 在指定位宽的DanceDD上进行搜索并输出结果
+ * @param zdd 读取的ZDD。
+ * @param side_rows 在ZDD之外保存的选项。
+ * @param options 运行选项。
+ */
+template <typename Traits>
+void run(const RawZdd& zdd, const SideRows& side_rows,
+         const RunOptions& options) {
+    // 创建ZDD结构，并加载数据
+    ZddWithLinks<Traits> zdd_with_links(zdd.num_var, false);
+    if (options.parallel_setup_threshold >= 0) {
+        zdd_with_links.set_parallel_setup_threshold(
+            options.parallel_setup_threshold);
+    }
+    auto load_start_time = std::chrono::system_clock::now();
+    if (!options.snapshot_in.empty()) {
+        zdd_with_links.load_snapshot(options.snapshot_in);
+    } else {
+        zdd_with_links.load_zdd(zdd);
+        zdd_with_links.load_side_rows(side_rows);
+    }
+    auto load_end_time = std::chrono::system_clock::now();
+    zdd_with_links.set_recompress_depth(options.recompress_depth,
+                                        options.recompress_ratio);
+    if (options.decompose_interval >= 0) {
+        zdd_with_links.set_decompose_interval(options.decompose_interval,
+                                              COMPONENT_CACHE_BYTES);
+    }
+    zdd_with_links.set_parallel_level_threshold(
+        options.parallel_level_threshold);
+
     // 进行一致性检查，失败则打印信息
     if (zdd_with_links.sanity()) {
         fprintf(stderr, "initial zdd is invalid\n");
     }
-    fprintf(stderr, "load files done\n");
+    // 与串行建立的结构比较
+    if (options.verify_setup && options.snapshot_in.empty()) {
+        ZddWithLinks<Traits> serial(zdd.num_var, false);
+        serial.set_parallel_setup_threshold(0);
+        serial.load_zdd(zdd);
+        serial.load_side_rows(side_rows);
+        fprintf(stderr, "setup %s serial setup\n",
+                serial == zdd_with_links ? "equals" : "differs from");
+    }
+    fprintf(stderr,
+            "load files done (%zu node cells, %zu bytes each, %lld msecs)\n",
+            zdd_with_links.num_nodes(),
+            ZddWithLinks<Traits>::NodeTable::bytes_per_node,
+            (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                load_end_time - load_start_time)
+                .count());
+    if (!options.snapshot_out.empty()) {
+        zdd_with_links.write_snapshot(options.snapshot_out);
+        fprintf(stderr, "snapshot written to %s\n",
+                options.snapshot_out.c_str());
+        return;
+    }
+    if (!options.query_file.empty()) {
+        run_queries(zdd_with_links, zdd.num_var, options.query_file,
+                    options.residual_prefix);
+        if (options.report_footprint) {
+            report_footprint(zdd_with_links);
+        }
+        return;
+    }
 
     // 用于存储搜索到的解
-    vector<vector<uint16_t>> solution;
+    vector<vector<typename Traits::var_t>> solution;
+    CacheMissCounter cache_misses;
     // 记录开始时间
     auto start_time = std::chrono::system_clock::now();
+    if (options.count_cache_misses) cache_misses.start();
     // 进行搜索
     zdd_with_links.search(solution, 0);
+    const uint64_t num_cache_misses = cache_misses.stop();
     // 记录结束时间
     auto end_time = std::chrono::system_clock::now();
     // 输出搜索结果，包括节点数、解的数量、更新次数和执行时间
-    printf("num nodes %llu, num solutions %llu, num updates %llu, "
-           "time: %llu msecs\n", ZddWithLinks::num_search_tree_nodes,
-           ZddWithLinks::num_solutions, ZddWithLinks::num_updates,
+    printf("num nodes %llu, num solutions %s, num updates %llu, "
+           "time: %llu msecs\n",
+           ZddWithLinks<Traits>::num_search_tree_nodes,
+           count_to_string(ZddWithLinks<Traits>::num_solutions).c_str(),
+           ZddWithLinks<Traits>::num_updates,
            std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
                                                                  start_time)
                .count());
+    if (options.recompress_depth >= 0) {
+        printf("recompressions %llu, skipped %llu\n",
+               (unsigned long long)ZddWithLinks<Traits>::num_recompressions,
+               (unsigned long long)ZddWithLinks<Traits>::num_recompress_skips);
+    }
+    if (const ComponentCache *cache = zdd_with_links.component_cache()) {
+        printf("decompositions %llu, component cache hits %llu of %llu\n",
+               (unsigned long long)ZddWithLinks<Traits>::num_decompositions,
+               (unsigned long long)cache->num_hits(),
+               (unsigned long long)cache->num_lookups());
+    }
+    if (options.count_cache_misses) {
+        if (cache_misses.available()) {
+            printf("cache misses %llu, %.3f per update\n",
+                   (unsigned long long)num_cache_misses,
+                   (double)num_cache_misses /
+                       std::max<uint64_t>(ZddWithLinks<Traits>::num_updates, 1));
+        } else {
+            printf("cache misses unavailable (perf_event_open failed)\n");
+        }
+    }
+    if (options.report_footprint) {
+        report_footprint(zdd_with_links);
+    }
+}
+
+/**
+ * 根据列数选择变量位宽后运行
+ * @param zdd 读取的ZDD。
+ * @param side_rows 在ZDD之外保存的选项。
+ * @param wide_vars 是否使用32位变量编号。
+ * @param options 运行选项。
+ */
+template <typename Count, typename Index>
+void run_with_index(const RawZdd& zdd, const SideRows& side_rows,
+                    bool wide_vars, const RunOptions& options) {
+    if (wide_vars) {
+        run<ZddTraits<Count, Index, uint32_t>>(zdd, side_rows, options);
+    } else {
+        run<ZddTraits<Count, Index, uint16_t>>(zdd, side_rows, options);
+    }
+}
+
+/**
+ * 根据节点数选择节点id位宽后运行
+ * @param zdd 读取的ZDD。
+ * @param side_rows 在ZDD之外保存的选项。
+ * @param wide_index 是否使用64位节点id和父链接。
+ * @param wide_vars 是否使用32位变量编号。
+ * @param options 运行选项。
+ */
+template <typename Count>
+void run_with_count(const RawZdd& zdd, const SideRows& side_rows,
+                    bool wide_index, bool wide_vars,
+                    const RunOptions& options) {
+    if (wide_index) {
+        run_with_index<Count, int64_t>(zdd, side_rows, wide_vars, options);
+    } else {
+        run_with_index<Count, int32_t>(zdd, side_rows, wide_vars, options);
+    }
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    vector<string> zdd_file_names;
+    string expression;
+    size_t cache_mib = 512;
+    string option_file_name;
+    string graph_file_name;
+    string secondary_file_name;
+    string bounds_file_name;
+    FrontierKind frontier_kind = FrontierKind::Component;
+    size_t min_size = 1, max_size = SIZE_MAX;
+    RunOptions options;
+    int min_count_bits = 32;
+    bool wide_index = false;
+    bool wide_vars = false;
+    bool renumber = false;
+    
+    // 解析命令行参数
+    while ((opt = getopt(argc, argv, "z:e:M:x:g:k:n:y:b:q:W:s:S:r:K:F:R:c:wCplmL:P:Vh")) != -1) {
+        switch (opt) {
+            case 'z':
+                zdd_file_names.push_back(optarg);// 读取 -z 参数之后的ZDD文件名，可以指定多个
+                break;
+            case 'e':
+                expression = optarg;// 组合多个ZDD的表达式
+                break;
+            case 'M':
+                cache_mib = strtoull(optarg, nullptr, 10);// 运算缓存的内存上限（MiB）
+                break;
+            case 'x':
+                option_file_name = optarg;// 读取DLX格式的选项文件名
+                break;
+            case 'g':
+                graph_file_name = optarg;// 读取边列表文件名
+                break;
+            case 'k':
+                // 选项的诱导子图的种类
+                if (strcmp(optarg, "component") == 0) {
+                    frontier_kind = FrontierKind::Component;
+                } else if (strcmp(optarg, "path") == 0) {
+                    frontier_kind = FrontierKind::Path;
+                } else if (strcmp(optarg, "cycle") == 0) {
+                    frontier_kind = FrontierKind::Cycle;
+                } else {
+                    show_help_and_exit();
+                }
+                break;
+            case 'n':
+                // 选项的顶点数范围 min:max，省略max表示不限
+                min_size = strtoull(optarg, nullptr, 10);
+                if (const char* colon = strchr(optarg, ':')) {
+                    max_size = strtoull(colon + 1, nullptr, 10);
+                }
+                break;
+            case 'y':
+                secondary_file_name = optarg;// 声明次要列的文件名
+                break;
+            case 'b':
+                bounds_file_name = optarg;// 声明覆盖次数上下界的文件名
+                break;
+            case 'q':
+                options.query_file = optarg;// 在加载的实例上回答的查询文件
+                break;
+            case 'W':
+                options.residual_prefix = optarg;// 查询的残余ZDD的文件名前缀
+                break;
+            case 's':
+                options.snapshot_in = optarg;// 读取快照文件名
+                break;
+            case 'S':
+                options.snapshot_out = optarg;// 写入快照的文件名
+                break;
+            case 'r':
+                // 重新压缩的搜索深度 depth[:ratio]
+                options.recompress_depth = atoi(optarg);
+                if (const char* colon = strchr(optarg, ':')) {
+                    options.recompress_ratio = atof(colon + 1);
+                }
+                break;
+            case 'K':
+                options.decompose_interval = atoi(optarg);// 连通分量分解的间隔
+                break;
+            case 'F':
+                // 前沿动态规划的最大宽度，状态保存在64位中
+                options.frontier_width_limit = min(atoi(optarg), 64);
+                options.frontier_width_given = true;
+                break;
+            case 'R':
+                // 把选项移出ZDD的阈值 ratio[:nodes]
+                options.side_row_ratio = atof(optarg);
+                if (const char* colon = strchr(optarg, ':')) {
+                    options.side_row_min_nodes = strtoull(colon + 1, nullptr, 10);
+                }
+                break;
+            case 'c':
+                min_count_bits = atoi(optarg);// 读取最小计数位宽
+                options.layout_options = true;
+                if (min_count_bits != 32 && min_count_bits != 64 &&
+                    min_count_bits != 128) {
+                    fprintf(stderr, "-c must be 32, 64 or 128: %s\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'w':
+                wide_index = true;// 强制使用64位节点id
+                options.layout_options = true;
+                break;
+            case 'C':
+                wide_vars = true;// 强制使用32位变量编号
+                options.layout_options = true;
+                break;
+            case 'p':
+                options.count_cache_misses = true;// 统计缓存未命中数
+                break;
+            case 'l':
+                renumber = true;// 加载时按局部性重新编号节点
+                options.layout_options = true;
+                break;
+            case 'm':
+                options.report_footprint = true;// 报告各数据结构的内存占用
+                break;
+            case 'L':
+                options.parallel_level_threshold = atol(optarg);// 并行处理一层的最小节点数
+                break;
+            case 'P':
+                options.parallel_setup_threshold = atol(optarg);// 并行建立舞动链接的最小节点数
+                options.layout_options = true;
+                break;
+            case 'V':
+                options.verify_setup = true;// 与串行建立的结构比较
+                break;
+            case 'h':
+                show_help_and_exit();// 读取失败就显示用法
+                break;
+        }
+    }
+    
+    // ZDD文件、选项文件和快照文件须指定且只指定一个，否则显示用法并退出
+    if (!zdd_file_names.empty() + !option_file_name.empty() +
+            !graph_file_name.empty() + !options.snapshot_in.empty() !=
+        1) {
+        show_help_and_exit();
+    }
+    // 多个ZDD文件须由表达式组合
+    if (zdd_file_names.size() > 1 && expression.empty()) {
+        show_help_and_exit();
+    }
+    // 残余问题按查询写出
+    if (!options.residual_prefix.empty() && options.query_file.empty()) {
+        show_help_and_exit();
+    }
+    // 快照中已经保存了次要列
+    if (!options.snapshot_in.empty() &&
+        !(secondary_file_name.empty() && bounds_file_name.empty())) {
+        show_help_and_exit();
+    }
+
+    RawZdd zdd;
+    SideRows side_rows;
+    int count_bits;
+    if (!options.snapshot_in.empty()) {
+        // 快照的位宽在写入时已经确定
+        const SnapshotHeader header = read_snapshot_header(options.snapshot_in);
+        zdd.num_var = header.num_var;
+        count_bits = header.count_bytes * 8;
+        wide_index = header.index_bytes == 8;
+        wide_vars = header.var_bytes == 4;
+    } else {
+        // 读取ZDD文件或由选项构建ZDD，并根据选项数量选择计数位宽
+        if (!option_file_name.empty()) {
+            auto build_start_time = std::chrono::system_clock::now();
+            const OptionList option_list = read_option_file(option_file_name);
+            size_t num_duplicates;
+            zdd = build_zdd_from_options(option_list, num_duplicates);
+            fprintf(stderr,
+                    "built zdd of %zu nodes from %zu items, %zu options "
+                    "(%zu duplicates removed, %lld msecs)\n",
+                    zdd.nodes.size(), option_list.items.size(),
+                    option_list.num_options(), num_duplicates,
+                    (long long)std::chrono::duration_cast<
+                        std::chrono::milliseconds>(
+                        std::chrono::system_clock::now() - build_start_time)
+                        .count());
+            if (zdd.nodes.empty()) {
+                fprintf(stderr, "no options in %s\n",
+                        option_file_name.c_str());
+                exit(1);
+            }
+        } else if (!graph_file_name.empty()) {
+            auto build_start_time = std::chrono::system_clock::now();
+            const Graph graph = read_edge_list(graph_file_name);
+            zdd = build_frontier_zdd(graph, frontier_kind, min_size, max_size);
+            fprintf(stderr,
+                    "built zdd of %zu nodes from %zu vertices, %zu edges "
+                    "(%lld msecs)\n",
+                    zdd.nodes.size(), graph.vertices.size(),
+                    graph.edges.size(),
+                    (long long)std::chrono::duration_cast<
+                        std::chrono::milliseconds>(
+                        std::chrono::system_clock::now() - build_start_time)
+                        .count());
+            if (zdd.nodes.empty()) {
+                fprintf(stderr, "no options in %s\n", graph_file_name.c_str());
+                exit(1);
+            }
+        } else if (!expression.empty()) {
+            // 逐个导入到同一个节点存储，读取下一个文件前释放
+            auto apply_start_time = std::chrono::system_clock::now();
+            ZddAlgebra algebra(cache_mib << 20);
+            vector<int64_t> operands;
+            for (const string& file_name : zdd_file_names) {
+                operands.push_back(algebra.add(read_reduced_zdd(file_name)));
+            }
+            zdd = algebra.extract(algebra.evaluate(expression, operands));
+            fprintf(stderr,
+                    "applied expression: zdd of %zu nodes (%zu nodes "
+                    "created, %zu cache entries, %lld msecs)\n",
+                    zdd.nodes.size(), algebra.num_nodes(),
+                    algebra.cache_entries(),
+                    (long long)std::chrono::duration_cast<
+                        std::chrono::milliseconds>(
+                        std::chrono::system_clock::now() - apply_start_time)
+                        .count());
+            if (zdd.nodes.empty()) {
+                fprintf(stderr, "no options in the result of %s\n",
+                        expression.c_str());
+                exit(1);
+            }
+        } else {
+            zdd = read_reduced_zdd(zdd_file_names[0]);
+            if (zdd.nodes.empty()) {
+                fprintf(stderr, "no options in %s\n",
+                        zdd_file_names[0].c_str());
+                exit(1);
+            }
+        }
+        // 次要列和覆盖次数的上下界：-y / -b 指定的文件，
+        // 或ZDD文件旁的 zdd_file.secondary / zdd_file.bounds
+        if (secondary_file_name.empty() && zdd_file_names.size() == 1 &&
+            access((zdd_file_names[0] + ".secondary").c_str(), R_OK) == 0) {
+            secondary_file_name = zdd_file_names[0] + ".secondary";
+        }
+        if (!secondary_file_name.empty()) {
+            const vector<uint32_t> columns =
+                read_secondary_columns(secondary_file_name);
+            vector<uint32_t> merged;
+            set_union(zdd.secondary.begin(), zdd.secondary.end(),
+                      columns.begin(), columns.end(), back_inserter(merged));
+            zdd.secondary.swap(merged);
+        }
+        if (bounds_file_name.empty() && zdd_file_names.size() == 1 &&
+            access((zdd_file_names[0] + ".bounds").c_str(), R_OK) == 0) {
+            bounds_file_name = zdd_file_names[0] + ".bounds";
+        }
+        apply_column_bounds(zdd, bounds_file_name.empty()
+                                     ? vector<ColumnBounds>()
+                                     : read_column_bounds(bounds_file_name));
+        if (!zdd.bounds.empty() &&
+            (options.recompress_depth >= 0 || options.decompose_interval >= 0 ||
+             !options.snapshot_out.empty() ||
+             !options.residual_prefix.empty())) {
+            fprintf(stderr, "-r, -K, -S and -W are not supported with column "
+                            "bounds\n");
+            exit(1);
+        }
+        // 搜索不会选择只包含次要列的选项，删除它们
+        if (!zdd.secondary.empty()) {
+            const size_t num_nodes = zdd.nodes.size();
+            remove_secondary_only_options(zdd);
+            fprintf(stderr, "%zu secondary columns, zdd of %zu -> %zu nodes\n",
+                    zdd.secondary.size(), num_nodes, zdd.nodes.size());
+            if (zdd.nodes.empty()) {
+                fprintf(stderr, "no options containing primary columns\n");
+                if (!options.snapshot_out.empty() ||
+                    !options.query_file.empty()) {
+                    exit(1);
+                }
+                // 没有主列时空选择是唯一的解，否则有未能覆盖的主列。
+                // 不进行搜索，因此只输出解数
+                const size_t num_secondary =
+                    count_if(zdd.secondary.begin(), zdd.secondary.end(),
+                             [&](uint32_t col) {
+                                 return col >= 1 && col <= zdd.num_var;
+                             });
+                printf("num solutions %d\n",
+                       num_secondary == (size_t)zdd.num_var ? 1 : 0);
+                return 0;
+            }
+        }
+        // 前沿宽度小时不建立舞动链接，以动态规划计数
+        if (options.frontier_width_given && options.frontier_width_limit > 0 &&
+            (options.requires_search() || !zdd.bounds.empty())) {
+            fprintf(stderr, "-F ignored: other options require the search\n");
+        }
+        if (options.frontier_width_limit > 0 && !options.requires_search() &&
+            zdd.bounds.empty() &&
+            count_by_frontier_dp(zdd, options.frontier_width_limit)) {
+            return 0;
+        }
+        // 共享程度低的选项作为普通的行保存（快照和写出的残余问题只保存ZDD）
+        if (options.side_row_ratio > 0 && options.snapshot_out.empty() &&
+            options.residual_prefix.empty() && zdd.bounds.empty()) {
+            const size_t num_nodes = zdd.nodes.size();
+            side_rows = split_unshared_options(zdd, options.side_row_ratio,
+                                               options.side_row_min_nodes);
+            if (side_rows.num_rows() > 0) {
+                fprintf(stderr,
+                        "kept %zu options (%zu cells) as side rows, zdd of "
+                        "%zu -> %zu nodes\n",
+                        side_rows.num_rows(), side_rows.elements.size(),
+                        num_nodes, zdd.nodes.size());
+            }
+        }
+        if (renumber) {
+            renumber_for_locality(zdd);
+        }
+        count_bits = max(required_count_bits(zdd, side_rows.num_rows()),
+                         min_count_bits);
+        // 节点数或行的单元数超过32位父链接的上限时使用64位节点id
+        wide_index = wide_index || requires_wide_index(zdd) ||
+                     side_rows.elements.size() + zdd.num_var >=
+                         (size_t)numeric_limits<int32_t>::max();
+        // 列数超过16位列头链接的上限时使用32位变量编号
+        wide_vars = wide_vars || requires_wide_vars(zdd);
+    }
+    fprintf(stderr,
+            "count width %d bits, index width %d bits, var width %d bits\n",
+            count_bits, wide_index ? 64 : 32, wide_vars ? 32 : 16);
+
+    switch (count_bits) {
+        case 32:
+            run_with_count<uint32_t>(zdd, side_rows, wide_index, wide_vars, options);
+            break;
+        case 64:
+            run_with_count<uint64_t>(zdd, side_rows, wide_index, wide_vars, options);
+            break;
+        default:
+            run_with_count<count128_t>(zdd, side_rows, wide_index, wide_vars, options);
+            break;
+    }
 
     return 0;
 }
\ No newline at end of file
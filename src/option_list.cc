@@ -0,0 +1,225 @@
+#include "option_list.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+#include "unique_table.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief 把一行按空白分割为单词。
+ */
+void split_words(const string &line, vector<string> &words) {
+    words.clear();
+    size_t p = 0;
+    for (;;) {
+        while (p < line.size() && isspace((unsigned char)line[p])) p++;
+        if (p == line.size()) break;
+        const size_t begin = p;
+        while (p < line.size() && !isspace((unsigned char)line[p])) p++;
+        words.emplace_back(line, begin, p - begin);
+    }
+}
+
+/**
+ * builder of a ZDD from options sorted in lexicographic order.
+ * 由按字典序排序的选项构建ZDD。
+ */
+class ZddBuilder {
+   public:
+    ZddBuilder(const OptionList &options, const vector<uint64_t> &order,
+               vector<RawNode> &nodes)
+        : options_(options), order_(order), table_(nodes) {}
+
+    /**
+     * @brief 构建 order_[b, e) 中各选项去掉前d个项目后的集合族。
+     * @param has_empty 集合族是否还包含空集。[b, e) 的选项都多于d个项目。
+     * @return 根节点id或终端。
+     * @details 第d个项目相同的选项是连续的，从最后一组开始依次作为lo链构建，
+     *          因此递归深度只与选项的长度有关。
+     */
+    int64_t build(size_t b, size_t e, size_t d, bool has_empty) {
+        int64_t lo = has_empty ? DD_ONE_TERM : DD_ZERO_TERM;
+        while (e > b) {
+            const uint32_t item = element(e - 1, d);
+            // 二分查找该组的开头
+            size_t start = b, last = e - 1;
+            while (start < last) {
+                const size_t mid = start + (last - start) / 2;
+                if (element(mid, d) < item) {
+                    start = mid + 1;
+                } else {
+                    last = mid;
+                }
+            }
+            // 只有该项目的选项排在组的最前面，去重后至多一个
+            const bool hi_empty = length(start) == d + 1;
+            const int64_t hi = build(start + hi_empty, e, d + 1, hi_empty);
+            lo = table_.get(item + 1, lo, hi);
+            e = start;
+        }
+        return lo;
+    }
+
+   private:
+    uint32_t element(size_t pos, size_t d) const {
+        return options_.elements[options_.offsets[order_[pos]] + d];
+    }
+    size_t length(size_t pos) const {
+        return options_.offsets[order_[pos] + 1] - options_.offsets[order_[pos]];
+    }
+
+    const OptionList &options_;
+    const vector<uint64_t> &order_;
+    UniqueTable table_;
+};
+
+}  // namespace
+
+OptionList read_option_file(const string &file_name) {
+    ifstream ifs(file_name);
+    if (!ifs) {
+        cerr << "can't open " << file_name << endl;
+        exit(1);
+    }
+    OptionList options;
+    unordered_map<string, uint32_t> item_ids;
+    vector<string> words;
+    vector<uint32_t> option;
+    string line;
+    size_t line_no = 0;
+    bool has_items = false;
+    while (getline(ifs, line)) {
+        line_no++;
+        if (!line.empty() && line[0] == '|') continue;  // comment
+        split_words(line, words);
+        if (words.empty()) continue;
+        if (!has_items) {
+            has_items = true;
+            options.num_primary = SIZE_MAX;
+            for (string word : words) {
+                if (word == "|") {
+                    if (options.num_primary != SIZE_MAX) {
+                        cerr << file_name << ":" << line_no
+                             << ": | appears twice" << endl;
+                        exit(1);
+                    }
+                    options.num_primary = options.items.size();
+                    continue;
+                }
+                // 主项目的重数 "l:u|name" 或 "u|name"
+                const size_t bar = word.find('|');
+                if (bar != string::npos) {
+                    const string bounds = word.substr(0, bar);
+                    char *end;
+                    unsigned long upper = strtoul(bounds.c_str(), &end, 10);
+                    unsigned long lower = upper;
+                    if (*end == ':') upper = strtoul(end + 1, &end, 10);
+                    if (*end != '\0' || upper == 0 || lower > upper ||
+                        upper > UINT32_MAX ||
+                        options.num_primary != SIZE_MAX) {
+                        cerr << file_name << ":" << line_no
+                             << ": invalid multiplicity " << word << endl;
+                        exit(1);
+                    }
+                    options.bounds.push_back({(uint32_t)options.items.size() + 1,
+                                              (uint32_t)lower,
+                                              (uint32_t)upper});
+                    word.erase(0, bar + 1);
+                }
+                if (word.find(':') != string::npos) {
+                    cerr << file_name << ":" << line_no
+                         << ": colors are not supported" << endl;
+                    exit(1);
+                }
+                if (!item_ids.emplace(word, options.items.size()).second) {
+                    cerr << file_name << ":" << line_no << ": item " << word
+                         << " is declared twice" << endl;
+                    exit(1);
+                }
+                options.items.push_back(word);
+            }
+            options.num_primary = min(options.num_primary, options.items.size());
+            continue;
+        }
+        option.clear();
+        for (const string &word : words) {
+            if (word.find(':') != string::npos) {
+                cerr << file_name << ":" << line_no
+                     << ": colors are not supported" << endl;
+                exit(1);
+            }
+            auto it = item_ids.find(word);
+            if (it == item_ids.end()) {
+                cerr << file_name << ":" << line_no << ": undefined item "
+                     << word << endl;
+                exit(1);
+            }
+            option.push_back(it->second);
+        }
+        sort(option.begin(), option.end());
+        if (adjacent_find(option.begin(), option.end()) != option.end()) {
+            cerr << file_name << ":" << line_no
+                 << ": an item appears twice in the option" << endl;
+            exit(1);
+        }
+        options.elements.insert(options.elements.end(), option.begin(),
+                                option.end());
+        options.offsets.push_back(options.elements.size());
+    }
+    if (!has_items) {
+        cerr << "no items in " << file_name << endl;
+        exit(1);
+    }
+    return options;
+}
+
+RawZdd build_zdd_from_options(const OptionList &options,
+                              size_t &num_duplicates) {
+    // 按字典序排序并去除重复的选项
+    vector<uint64_t> order(options.num_options());
+    for (size_t k = 0; k < order.size(); k++) order[k] = k;
+    auto option_begin = [&](uint64_t k) {
+        return options.elements.begin() + options.offsets[k];
+    };
+    auto option_end = [&](uint64_t k) {
+        return options.elements.begin() + options.offsets[k + 1];
+    };
+    sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b) {
+        return lexicographical_compare(option_begin(a), option_end(a),
+                                       option_begin(b), option_end(b));
+    });
+    const size_t num_options = order.size();
+    order.erase(unique(order.begin(), order.end(),
+                       [&](uint64_t a, uint64_t b) {
+                           return equal(option_begin(a), option_end(a),
+                                        option_begin(b), option_end(b));
+                       }),
+                order.end());
+    num_duplicates = num_options - order.size();
+
+    RawZdd zdd;
+    zdd.num_var = options.items.size();
+    for (size_t item = options.num_primary; item < options.items.size();
+         item++) {
+        zdd.secondary.push_back(item + 1);
+    }
+    zdd.bounds = options.bounds;
+    if (order.empty()) return zdd;
+
+    // 节点按创建的顺序编号，子节点总在父节点之前
+    vector<RawNode> nodes;
+    ZddBuilder builder(options, order, nodes);
+    builder.build(0, order.size(), 0, false);
+    vector<uint64_t>().swap(order);
+
+    zdd.nodes = move(nodes);
+    sort_nodes_by_var(zdd);
+    return zdd;
+}
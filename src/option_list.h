@@ -0,0 +1,59 @@
+#ifndef OPTION_LIST_H_
+#define OPTION_LIST_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "raw_zdd.h"
+
+/**
+ * Options of an exact cover problem in Knuth's DLX text format.
+ * Lines starting with '|' are comments. The first other line names the
+ * items, and every following non-empty line is an option listing the names
+ * of its items. Items after a '|' in the item line are secondary (covered at
+ * most once). A primary item written as "l:u|name" (or "u|name" for l = u)
+ * is covered between l and u times. Item i (0-based, in the order of the item
+ * line) is var i + 1 of the built ZDD, so the item line gives the variable
+ * order.
+ * Knuth的DLX文本格式的精确覆盖问题。
+ * 以'|'开头的行为注释，第一个其他行为项目名，之后每个非空行为一个选项。
+ * 项目行中'|'之后的项目为次要项目（至多被覆盖一次）。
+ * 写作"l:u|name"（l = u 时为"u|name"）的主项目被覆盖l到u次。
+ * 第i个项目（从0开始）对应ZDD的变量 i + 1，项目行的顺序即为变量顺序。
+ */
+struct OptionList {
+    std::vector<std::string> items;
+    // items[num_primary ..] are secondary
+    size_t num_primary = 0;
+    // multiplicities of primary items; the column of item i is i + 1
+    std::vector<ColumnBounds> bounds;
+    // items of all options; the items of an option are in ascending order
+    std::vector<uint32_t> elements;
+    // option k is elements[offsets[k] .. offsets[k + 1])
+    std::vector<uint64_t> offsets{0};
+
+    size_t num_options() const { return offsets.size() - 1; }
+};
+
+/**
+ * @brief 读取DLX格式的选项文件。
+ * @param file_name 选项文件名。
+ * @return 读取的选项。未定义的项目、选项中重复的项目和颜色报错并退出。
+ */
+OptionList read_option_file(const std::string &file_name);
+
+/**
+ * @brief 由选项构建约简的ZDD。
+ * @param options 选项。
+ * @param num_duplicates 输出被去除的重复选项数（ZDD表示集合族，重复的选项只保留一个）。
+ * @return 按Graphillion输出的顺序（相同var的节点连续、var降序、根节点在最后）排列的ZDD，
+ *         可直接传给 ZddWithLinks::load_zdd。num_var 为项目数，secondary 为次要项目的变量，bounds 为主项目的重数。
+ * @details 选项按字典序排序后，自下而上构建：子节点总是先于父节点创建，
+ *          通过唯一表（var, lo, hi）共享相同的子ZDD。
+ *          除选项本身外只使用排序的下标和唯一表，内存与节点数成正比。
+ */
+RawZdd build_zdd_from_options(const OptionList &options,
+                              size_t &num_duplicates);
+
+#endif  // OPTION_LIST_H_
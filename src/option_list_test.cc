@@ -0,0 +1,235 @@
+// randomized check of building ZDDs from DLX option files and of the counts
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#include "dancing_on_zdd.h"
+#include "dp_manager.h"
+#include "frontier_count.h"
+#include "option_list.h"
+#include "raw_zdd.h"
+#include "test_util.h"
+
+using Traits = ZddTraits<count128_t, int32_t, uint16_t>;
+
+/**
+ * 一个随机的问题：项目（前 num_primary 个为主项目）、主项目的重数和选项。
+ */
+struct Instance {
+    int num_items = 0;
+    int num_primary = 0;
+    vector<ColumnBounds> bounds;  // 列 i + 1 为项目 i
+    vector<vector<uint32_t>> options;  // 项目的下标，未排序，可以重复
+};
+
+/**
+ * @brief 以DLX格式写出问题，项目名为 i0, i1, ...
+ */
+void write_instance(const Instance &instance, const string &file_name) {
+    std::ofstream out(file_name);
+    out << "| random instance\n";
+    auto bound = instance.bounds.begin();
+    for (int i = 0; i < instance.num_items; i++) {
+        if (i == instance.num_primary) out << "| ";
+        if (bound != instance.bounds.end() &&
+            bound->column == (uint32_t)i + 1) {
+            if (bound->lower == bound->upper) {
+                out << bound->upper << "|";
+            } else {
+                out << bound->lower << ":" << bound->upper << "|";
+            }
+            ++bound;
+        }
+        out << "i" << i << " ";
+    }
+    out << "\n";
+    for (const vector<uint32_t> &option : instance.options) {
+        for (const uint32_t item : option) out << "i" << item << " ";
+        out << "\n";
+    }
+}
+
+/**
+ * @brief 穷举不同选项的子集来计数：主项目被覆盖的次数在上下界之间（默认恰好一次），
+ *        次要项目至多一次。不选择只包含次要项目的选项。
+ */
+uint64_t brute_force_count(const Instance &instance, const Family &options) {
+    vector<uint32_t> lower(instance.num_items + 1, 1);
+    vector<uint32_t> upper(instance.num_items + 1, 1);
+    for (int col = instance.num_primary + 1; col <= instance.num_items;
+         col++) {
+        lower[col] = 0;
+    }
+    for (const ColumnBounds &b : instance.bounds) {
+        lower[b.column] = b.lower;
+        upper[b.column] = b.upper;
+    }
+    vector<vector<uint32_t>> candidates;
+    for (const vector<uint32_t> &option : options) {
+        if (option.front() <= (uint32_t)instance.num_primary) {
+            candidates.push_back(option);
+        }
+    }
+    uint64_t count = 0;
+    vector<uint32_t> covered(instance.num_items + 1);
+    for (uint64_t mask = 0; mask < (uint64_t(1) << candidates.size());
+         mask++) {
+        fill(covered.begin(), covered.end(), 0);
+        for (size_t k = 0; k < candidates.size(); k++) {
+            if (mask >> k & 1) {
+                for (const uint32_t col : candidates[k]) covered[col]++;
+            }
+        }
+        bool ok = true;
+        for (int col = 1; col <= instance.num_items && ok; col++) {
+            ok = covered[col] >= lower[col] && covered[col] <= upper[col];
+        }
+        if (ok) count++;
+    }
+    return count;
+}
+
+/**
+ * @brief 以舞动链接搜索计数。
+ * @param decompose 是否在根节点进行连通分量分解。
+ * @param side_rows 在ZDD之外的选项。
+ */
+count128_t search_count(const RawZdd &zdd, bool decompose,
+                        const SideRows &side_rows = SideRows()) {
+    ZddWithLinks<Traits> zdd_with_links(zdd.num_var);
+    zdd_with_links.load_zdd(zdd);
+    zdd_with_links.load_side_rows(side_rows);
+    if (decompose) zdd_with_links.set_decompose_interval(0, size_t(1) << 20);
+    vector<vector<Traits::var_t>> solution;
+    ZddWithLinks<Traits>::num_solutions = 0;
+    zdd_with_links.search(solution, 0);
+    return ZddWithLinks<Traits>::num_solutions;
+}
+
+/**
+ * @brief 检查一个随机问题：读取的项目、构建的ZDD的集合族、各种计数方法的解数。
+ */
+void check_instance(uint64_t seed, const string &file_name,
+                    int &num_failures) {
+    std::mt19937_64 rng(seed);
+    Instance instance;
+    instance.num_items = 2 + rng() % 7;
+    instance.num_primary = 1 + rng() % instance.num_items;
+    const bool with_bounds = rng() % 4 == 0;
+    for (int i = 0; with_bounds && i < instance.num_primary; i++) {
+        if (rng() % 2 == 0) continue;
+        const uint32_t lower = 1 + rng() % 2;
+        instance.bounds.push_back(
+            {(uint32_t)i + 1, lower, lower + (uint32_t)(rng() % 2)});
+    }
+    const size_t num_options = 1 + rng() % 10;
+    for (size_t k = 0; k < num_options; k++) {
+        vector<uint32_t> option;
+        while (option.empty()) {
+            for (int i = 0; i < instance.num_items; i++) {
+                if (rng() % 3 == 0) option.push_back(i);
+            }
+        }
+        shuffle(option.begin(), option.end(), rng);
+        instance.options.push_back(option);
+        // 重复的选项
+        if (rng() % 5 == 0) instance.options.push_back(option);
+    }
+    write_instance(instance, file_name);
+
+    Family expected;
+    for (const vector<uint32_t> &option : instance.options) {
+        vector<uint32_t> set;
+        for (const uint32_t item : option) set.push_back(item + 1);
+        sort(set.begin(), set.end());
+        expected.insert(set);
+    }
+
+    const OptionList options = read_option_file(file_name);
+    check(options.items.size() == (size_t)instance.num_items &&
+              options.num_primary == (size_t)instance.num_primary &&
+              options.num_options() == instance.options.size(),
+          "items and options read", seed, num_failures);
+    size_t num_duplicates;
+    RawZdd zdd = build_zdd_from_options(options, num_duplicates);
+    check(num_duplicates == instance.options.size() - expected.size(),
+          "number of duplicates", seed, num_failures);
+    check(enumerate_family(zdd) == expected, "family of the built zdd", seed,
+          num_failures);
+    RawZdd reduced = zdd;
+    check(reduce_zdd(reduced) == 0, "built zdd is reduced", seed,
+          num_failures);
+
+    const uint64_t count = brute_force_count(instance, expected);
+    // 与 d3x 相同，只包含次要项目的选项在搜索前删除
+    if (!zdd.secondary.empty()) remove_secondary_only_options(zdd);
+    if (zdd.nodes.empty()) {
+        check(count == 0, "count without options", seed, num_failures);
+        return;
+    }
+    check(search_count(zdd, false) == count, "search count", seed,
+          num_failures);
+    if (!zdd.bounds.empty()) return;
+    check(search_count(zdd, true) == count, "search count with components",
+          seed, num_failures);
+    FrontierCounter counter(zdd);
+    check(counter.count() == count, "frontier dp count", seed, num_failures);
+    RawZdd split = zdd;
+    const SideRows side_rows = split_unshared_options(split, 0.1, 1);
+    check(search_count(split, false, side_rows) == count,
+          "search count with side rows", seed, num_failures);
+}
+
+/**
+ * @brief 45个相互独立、各有3个解的分量：解数 3^45 超过64位。
+ */
+void check_wide_count(int &num_failures) {
+    const int num_components = 45;
+    OptionList options;
+    for (int c = 0; c < num_components; c++) {
+        for (const char *name : {"a", "b", "c"}) {
+            options.items.push_back(name + std::to_string(c));
+        }
+    }
+    options.num_primary = options.items.size();
+    for (uint32_t c = 0; c < (uint32_t)num_components; c++) {
+        // {a b c}, {a} {b c}, {a b} {c}
+        for (const vector<uint32_t> &option :
+             vector<vector<uint32_t>>{{0, 1, 2}, {0}, {1, 2}, {0, 1}, {2}}) {
+            for (const uint32_t item : option) {
+                options.elements.push_back(3 * c + item);
+            }
+            options.offsets.push_back(options.elements.size());
+        }
+    }
+    size_t num_duplicates;
+    const RawZdd zdd = build_zdd_from_options(options, num_duplicates);
+    count128_t expected = 1;
+    for (int c = 0; c < num_components; c++) expected *= 3;
+    check(search_count(zdd, true) == expected,
+          "3^45 solutions with components", 0, num_failures);
+    FrontierCounter counter(zdd);
+    check(counter.count() == expected, "3^45 solutions with frontier dp", 0,
+          num_failures);
+}
+
+/**
+ * 随机生成DLX格式的问题（有重复的选项、未被覆盖的项目、次要项目和重数），
+ * 检查读取和构建的ZDD的集合族，并与穷举比较搜索、分量分解、前沿动态规划
+ * 和ZDD之外的行的解数。
+ * usage: ./option_list_test [num_instances]
+ */
+int main(int argc, char **argv) {
+    const int num_instances = argc > 1 ? atoi(argv[1]) : 600;
+    const string file_name = "option_list_test.dlx";
+    int num_failures = 0;
+    for (int seed = 0; seed < num_instances; seed++) {
+        check_instance(seed, file_name, num_failures);
+    }
+    check_wide_count(num_failures);
+    remove(file_name.c_str());
+    printf("%d instances, %d failures\n", num_instances, num_failures);
+    return num_failures == 0 ? 0 : 1;
+}
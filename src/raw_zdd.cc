@@ -0,0 +1,759 @@
+#include "raw_zdd.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+#include "decompress.h"
+#include "unique_table.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// 解析结果中表示⊤/⊥终端的值（与 DD_ONE_TERM / DD_ZERO_TERM 相同）
+constexpr int64_t RAW_ONE_TERM = DD_ONE_TERM;
+constexpr int64_t RAW_ZERO_TERM = DD_ZERO_TERM;
+
+/**
+ * 一行解析的结果，lo / hi 为文件中的节点id或终端。
+ */
+struct ParsedLine {
+    int64_t nid;
+    int64_t lo;
+    int64_t hi;
+    uint32_t var;
+};
+
+inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+/**
+ * @brief 解析一个非负整数。
+ * @return 成功时返回 true，p 指向整数之后。
+ */
+inline bool parse_uint(const char *&p, const char *end, int64_t &value) {
+    while (p < end && is_space(*p)) p++;
+    if (p == end || *p < '0' || *p > '9') return false;
+    int64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    value = v;
+    return true;
+}
+
+/**
+ * @brief 解析子节点：B（⊥）、T（⊤）或节点id。
+ */
+inline bool parse_child(const char *&p, const char *end, int64_t &value) {
+    while (p < end && is_space(*p)) p++;
+    if (p < end && (*p == 'B' || *p == 'T')) {
+        value = *p == 'B' ? RAW_ZERO_TERM : RAW_ONE_TERM;
+        p++;
+        return true;
+    }
+    return parse_uint(p, end, value);
+}
+
+/**
+ * @brief 解析[begin, end)中的所有行。
+ * @param error_line 出错时设为出错行的开头，否则不修改。
+ */
+void parse_lines(const char *begin, const char *end, vector<ParsedLine> &lines,
+                 const char *&error_line) {
+    for (const char *p = begin; p < end;) {
+        const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        const char *q = p;
+        while (q < eol && is_space(*q)) q++;
+        if (q < eol && *q != '.' && *q != '#') {
+            ParsedLine line;
+            int64_t var;
+            if (!parse_uint(q, eol, line.nid) || !parse_uint(q, eol, var) ||
+                !parse_child(q, eol, line.lo) || !parse_child(q, eol, line.hi)) {
+                error_line = p;
+                return;
+            }
+            line.var = var;
+            lines.push_back(line);
+        }
+        p = eol + 1;
+    }
+}
+
+/**
+ * @brief 报告无法解析的行并退出。
+ * @param line 该行的开头。
+ * @param end 文本的末尾。
+ */
+[[noreturn]] void report_invalid_line(const string &file_name,
+                                      const char *line, const char *end) {
+    const char *eol = static_cast<const char *>(memchr(line, '\n', end - line));
+    cerr << "invalid line in " << file_name << ": "
+         << string(line, eol ? eol : end) << endl;
+    exit(1);
+}
+
+/**
+ * @brief 以mmap映射未压缩的文件，按行边界分块并行解析。
+ * @param chunk_lines 输出各块解析的行。
+ */
+void parse_mapped_file(const string &file_name,
+                       vector<vector<ParsedLine>> &chunk_lines) {
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        cerr << "can't open " << file_name << endl;
+        exit(1);
+    }
+
+    const size_t size = st.st_size;
+    if (size == 0) {
+        close(fd);
+        return;
+    }
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        cerr << "can't map " << file_name << endl;
+        exit(1);
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    const char *text = static_cast<const char *>(map);
+
+    // 按行边界分块，各块并行解析
+    const size_t min_chunk_size = 1 << 20;
+#ifdef _OPENMP
+    const size_t num_chunks =
+        max<size_t>(1, min<size_t>(size / min_chunk_size,
+                                   4 * omp_get_max_threads()));
+#else
+    const size_t num_chunks = 1;
+#endif
+    vector<const char *> bounds(num_chunks + 1, text + size);
+    bounds[0] = text;
+    for (size_t c = 1; c < num_chunks; c++) {
+        const char *p = max(text + size * c / num_chunks, bounds[c - 1]);
+        const char *eol = static_cast<const char *>(
+            memchr(p, '\n', text + size - p));
+        bounds[c] = eol ? eol + 1 : text + size;
+    }
+    chunk_lines.resize(num_chunks);
+    vector<const char *> chunk_errors(num_chunks, nullptr);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t c = 0; c < num_chunks; c++) {
+        parse_lines(bounds[c], bounds[c + 1], chunk_lines[c], chunk_errors[c]);
+    }
+    for (const char *error_line : chunk_errors) {
+        if (!error_line) continue;
+        report_invalid_line(file_name, error_line, text + size);
+    }
+    munmap(map, size);
+}
+
+/**
+ * @brief 流式解压并解析压缩文件。
+ * @param chunk_lines 输出各块解析的行。
+ * 解压线程把解压后的块放入有界队列，当前线程同时解析已解压的块，
+ * 跨越块边界的行拼接后解析。
+ */
+void parse_compressed_file(const string &file_name, Compression compression,
+                           vector<vector<ParsedLine>> &chunk_lines) {
+    DecompressStream stream(file_name, compression);
+    const size_t block_size = 4 << 20;
+    const size_t max_queued_blocks = 4;
+
+    mutex m;
+    condition_variable cv;
+    deque<vector<char>> queue;  // 空的块表示文件结束
+    thread decompressor([&]() {
+        for (;;) {
+            vector<char> block(block_size);
+            block.resize(stream.read(block.data(), block_size));
+            const bool end = block.empty();
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [&]() { return queue.size() < max_queued_blocks; });
+                queue.push_back(move(block));
+            }
+            cv.notify_all();
+            if (end) break;
+        }
+    });
+
+    auto parse = [&](const char *begin, const char *end) {
+        chunk_lines.emplace_back();
+        const char *error_line = nullptr;
+        parse_lines(begin, end, chunk_lines.back(), error_line);
+        if (error_line) report_invalid_line(file_name, error_line, end);
+    };
+    string carry;  // 上一块中未结束的行
+    for (;;) {
+        vector<char> block;
+        {
+            unique_lock<mutex> lock(m);
+            cv.wait(lock, [&]() { return !queue.empty(); });
+            block = move(queue.front());
+            queue.pop_front();
+        }
+        cv.notify_all();
+        if (block.empty()) break;
+
+        const char *begin = block.data(), *end = block.data() + block.size();
+        const char *first_eol =
+            static_cast<const char *>(memchr(begin, '\n', end - begin));
+        if (!first_eol) {
+            carry.append(begin, end);
+            continue;
+        }
+        carry.append(begin, first_eol + 1);
+        parse(carry.data(), carry.data() + carry.size());
+        const char *last_eol = static_cast<const char *>(
+            memrchr(first_eol, '\n', end - first_eol));
+        parse(first_eol + 1, last_eol + 1);
+        carry.assign(last_eol + 1, end);
+    }
+    decompressor.join();
+    if (!carry.empty()) parse(carry.data(), carry.data() + carry.size());
+}
+
+}  // namespace
+
+RawZdd read_zdd_file(const string &file_name) {
+    vector<vector<ParsedLine>> chunk_lines;
+    const Compression compression = detect_compression(file_name);
+    if (compression == Compression::None) {
+        parse_mapped_file(file_name, chunk_lines);
+    } else {
+        parse_compressed_file(file_name, compression, chunk_lines);
+    }
+    const size_t num_chunks = chunk_lines.size();
+
+    RawZdd zdd;
+    // 各块的结果按顺序连接
+    vector<size_t> offsets(num_chunks + 1, 0);
+    for (size_t c = 0; c < num_chunks; c++) {
+        offsets[c + 1] = offsets[c] + chunk_lines[c].size();
+    }
+    const size_t n = offsets[num_chunks];
+    vector<int64_t> nids(n);
+    zdd.nodes.resize(n);
+    int64_t min_nid = INT64_MAX, max_nid = INT64_MIN;
+    uint32_t max_var = 0;
+#pragma omp parallel for schedule(dynamic, 1) \
+    reduction(min : min_nid) reduction(max : max_nid, max_var)
+    for (size_t c = 0; c < num_chunks; c++) {
+        size_t i = offsets[c];
+        for (const ParsedLine &line : chunk_lines[c]) {
+            nids[i] = line.nid;
+            zdd.nodes[i] = {line.var, line.hi, line.lo};
+            min_nid = min(min_nid, line.nid);
+            max_nid = max(max_nid, line.nid);
+            max_var = max(max_var, line.var);
+            i++;
+        }
+        vector<ParsedLine>().swap(chunk_lines[c]);
+    }
+    zdd.num_var = max_var;
+    if (n == 0) return zdd;
+
+    // 文件中的节点id转换为行号。id较密集时使用直接索引的表，否则使用排序后的表
+    bool undefined = false;
+    if ((uint64_t)(max_nid - min_nid) < 4 * (uint64_t)n + 1024) {
+        vector<int64_t> dense(max_nid - min_nid + 1, -1);
+        for (size_t i = 0; i < n; i++) dense[nids[i] - min_nid] = i;
+        auto resolve = [&](int64_t &child) -> bool {
+            if (child < 0) return true;
+            if (child < min_nid || child > max_nid ||
+                dense[child - min_nid] < 0) {
+                return false;
+            }
+            child = dense[child - min_nid];
+            return true;
+        };
+#pragma omp parallel for reduction(|| : undefined)
+        for (size_t i = 0; i < n; i++) {
+            const bool found =
+                resolve(zdd.nodes[i].hi) && resolve(zdd.nodes[i].lo);
+            undefined = undefined || !found;
+        }
+    } else {
+        vector<pair<int64_t, int64_t>> sorted(n);
+        for (size_t i = 0; i < n; i++) sorted[i] = {nids[i], i};
+        sort(sorted.begin(), sorted.end());
+        auto resolve = [&](int64_t &child) -> bool {
+            if (child < 0) return true;
+            auto it = lower_bound(sorted.begin(), sorted.end(),
+                                  make_pair(child, INT64_MIN));
+            if (it == sorted.end() || it->first != child) {
+                return false;
+            }
+            child = it->second;
+            return true;
+        };
+#pragma omp parallel for reduction(|| : undefined)
+        for (size_t i = 0; i < n; i++) {
+            const bool found =
+                resolve(zdd.nodes[i].hi) && resolve(zdd.nodes[i].lo);
+            undefined = undefined || !found;
+        }
+    }
+    if (undefined) {
+        cerr << "undefined node id referenced in " << file_name << endl;
+        exit(1);
+    }
+    return zdd;
+}
+
+void write_zdd_file(const RawZdd &zdd, const string &file_name) {
+    FILE *fp = fopen(file_name.c_str(), "w");
+    if (!fp) {
+        cerr << "can't open " << file_name << endl;
+        exit(1);
+    }
+    auto child_str = [](int64_t id) {
+        if (id == DD_ZERO_TERM) return string("B");
+        if (id == DD_ONE_TERM) return string("T");
+        return to_string(id);
+    };
+    for (size_t i = 0; i < zdd.nodes.size(); i++) {
+        const RawNode &node = zdd.nodes[i];
+        fprintf(fp, "%zu %u %s %s\n", i, node.var, child_str(node.lo).c_str(),
+                child_str(node.hi).c_str());
+    }
+    fprintf(fp, ".\n");
+    if (fclose(fp) != 0) {
+        cerr << "can't write " << file_name << endl;
+        exit(1);
+    }
+}
+
+size_t reduce_zdd(RawZdd &zdd) {
+    const size_t n = zdd.nodes.size();
+    if (n == 0) return 0;
+    const vector<RawNode> &nodes = zdd.nodes;
+
+    // var须从父节点到子节点严格增大，这也保证了没有环
+    size_t invalid = n;
+    uint32_t max_var = zdd.num_var;
+#pragma omp parallel for reduction(min : invalid) reduction(max : max_var)
+    for (size_t i = 0; i < n; i++) {
+        const RawNode &node = nodes[i];
+        max_var = max(max_var, node.var);
+        if (node.var == 0 ||
+            (node.hi >= 0 && nodes[node.hi].var <= node.var) ||
+            (node.lo >= 0 && nodes[node.lo].var <= node.var)) {
+            invalid = min(invalid, i);
+        }
+    }
+    if (invalid < n) {
+        const RawNode &node = nodes[invalid];
+        cerr << "invalid zdd: node #" << invalid + 1;
+        if (node.var == 0) {
+            cerr << " has var 0" << endl;
+        } else {
+            cerr << " (var " << node.var
+                 << ") has a child whose var is not larger" << endl;
+        }
+        exit(1);
+    }
+
+    // 按var升序排列节点（计数排序），即父节点在子节点之前的拓扑顺序
+    vector<size_t> var_begin(max_var + 2, 0);
+    for (const RawNode &node : nodes) var_begin[node.var + 1]++;
+    partial_sum(var_begin.begin(), var_begin.end(), var_begin.begin());
+    vector<int64_t> order(n);
+    for (size_t i = 0; i < n; i++) order[var_begin[nodes[i].var]++] = i;
+
+    // 标记从根节点可到达的节点
+    vector<char> reachable(n, 0);
+    reachable[n - 1] = 1;
+    for (const int64_t i : order) {
+        if (!reachable[i]) continue;
+        if (nodes[i].hi >= 0) reachable[nodes[i].hi] = 1;
+        if (nodes[i].lo >= 0) reachable[nodes[i].lo] = 1;
+    }
+
+    // 按var降序经唯一表重建，创建的顺序即为Graphillion输出的顺序。
+    // 新建的节点都可从新的根节点到达，因此根节点最后创建
+    vector<RawNode> reduced;
+    UniqueTable table(reduced);
+    table.reserve(n);
+    vector<int64_t> new_id(n, DD_ZERO_TERM);
+    auto map_id = [&](int64_t id) { return id < 0 ? id : new_id[id]; };
+    for (size_t k = n; k-- > 0;) {
+        const int64_t i = order[k];
+        if (!reachable[i]) continue;
+        const RawNode &node = nodes[i];
+        new_id[i] = table.get(node.var, map_id(node.lo), map_id(node.hi));
+    }
+    if (new_id[n - 1] < 0) {
+        // 没有选项，或只有空集
+        reduced.clear();
+    }
+    zdd.nodes.swap(reduced);
+    return n - zdd.nodes.size();
+}
+
+vector<uint32_t> read_secondary_columns(const string &file_name) {
+    ifstream ifs(file_name);
+    if (!ifs) {
+        cerr << "can't open " << file_name << endl;
+        exit(1);
+    }
+    vector<uint32_t> columns;
+    string line, word;
+    size_t line_no = 0;
+    while (getline(ifs, line)) {
+        line_no++;
+        istringstream iss(line.substr(0, line.find('#')));
+        while (iss >> word) {
+            char *end;
+            const unsigned long long column = strtoull(word.c_str(), &end, 10);
+            if (*end != '\0' || column == 0 || column > UINT32_MAX) {
+                cerr << file_name << ":" << line_no << ": invalid column "
+                     << word << endl;
+                exit(1);
+            }
+            columns.push_back(column);
+        }
+    }
+    sort(columns.begin(), columns.end());
+    columns.erase(unique(columns.begin(), columns.end()), columns.end());
+    return columns;
+}
+
+vector<ColumnBounds> read_column_bounds(const string &file_name) {
+    ifstream ifs(file_name);
+    if (!ifs) {
+        cerr << "can't open " << file_name << endl;
+        exit(1);
+    }
+    vector<ColumnBounds> bounds;
+    string line;
+    size_t line_no = 0;
+    while (getline(ifs, line)) {
+        line_no++;
+        istringstream iss(line.substr(0, line.find('#')));
+        int64_t column, lower, upper;
+        if (!(iss >> column)) continue;
+        string rest;
+        if (!(iss >> lower >> upper) || (iss >> rest) || column <= 0 ||
+            column > UINT32_MAX || lower < 0 || upper <= 0 || lower > upper ||
+            upper > UINT32_MAX) {
+            cerr << file_name << ":" << line_no << ": invalid bounds" << endl;
+            exit(1);
+        }
+        bounds.push_back({(uint32_t)column, (uint32_t)lower, (uint32_t)upper});
+    }
+    sort(bounds.begin(), bounds.end(),
+         [](const ColumnBounds &a, const ColumnBounds &b) {
+             return a.column < b.column;
+         });
+    for (size_t i = 1; i < bounds.size(); i++) {
+        if (bounds[i - 1].column == bounds[i].column) {
+            cerr << file_name << ": bounds of column " << bounds[i].column
+                 << " are given twice" << endl;
+            exit(1);
+        }
+    }
+    return bounds;
+}
+
+void remove_secondary_only_options(RawZdd &zdd) {
+    const size_t n = zdd.nodes.size();
+    if (n == 0 || zdd.secondary.empty()) return;
+    vector<bool> is_secondary(zdd.num_var + 1, false);
+    for (const uint32_t col : zdd.secondary) {
+        if (col <= (uint32_t)zdd.num_var) is_secondary[col] = true;
+    }
+
+    // all[x]: x的集合族的副本；primary[x]: 其中包含主列的集合
+    vector<RawNode> nodes;
+    UniqueTable table(nodes);
+    table.reserve(2 * n);
+    vector<int64_t> all(n), primary(n);
+    auto all_of = [&](int64_t id) { return id < 0 ? id : all[id]; };
+    auto primary_of = [&](int64_t id) {
+        return id < 0 ? DD_ZERO_TERM : primary[id];
+    };
+    for (size_t id = 0; id < n; id++) {
+        const RawNode &node = zdd.nodes[id];
+        all[id] = table.get(node.var, all_of(node.lo), all_of(node.hi));
+        primary[id] = table.get(
+            node.var, primary_of(node.lo),
+            is_secondary[node.var] ? primary_of(node.hi) : all_of(node.hi));
+    }
+    const int64_t root = primary[n - 1];
+    if (root < 0) {
+        zdd.nodes.clear();
+        return;
+    }
+    // 根节点须为最后一个节点，reduce_zdd 合并其副本并删除不可到达的节点
+    nodes.push_back(nodes[root]);
+    zdd.nodes.swap(nodes);
+    reduce_zdd(zdd);
+}
+
+void remove_options(RawZdd &zdd, const vector<vector<uint32_t>> &options) {
+    const size_t n = zdd.nodes.size();
+    if (n == 0 || options.empty()) return;
+    vector<RawNode> nodes;
+    UniqueTable table(nodes);
+    table.reserve(n + options.size() * 16);
+    vector<int64_t> copy(n);
+    auto copy_of = [&](int64_t id) { return id < 0 ? id : copy[id]; };
+    for (size_t id = 0; id < n; id++) {
+        const RawNode &node = zdd.nodes[id];
+        copy[id] = table.get(node.var, copy_of(node.lo), copy_of(node.hi));
+    }
+    int64_t root = copy[n - 1];
+    // 沿选项的路径下降，记录经过的节点和分支，再自下而上重建路径
+    vector<pair<int64_t, bool>> path;
+    for (const vector<uint32_t> &option : options) {
+        path.clear();
+        size_t pos = 0;
+        int64_t id = root;
+        while (id >= 0) {
+            const RawNode node = nodes[id];
+            if (pos < option.size() && node.var == option[pos]) {
+                path.emplace_back(id, true);
+                id = node.hi;
+                pos++;
+            } else if (pos == option.size() || node.var < option[pos]) {
+                path.emplace_back(id, false);
+                id = node.lo;
+            } else {
+                break;
+            }
+        }
+        if (pos < option.size() || id != DD_ONE_TERM) continue;
+        id = DD_ZERO_TERM;
+        for (size_t i = path.size(); i-- > 0;) {
+            const RawNode node = nodes[path[i].first];
+            id = path[i].second ? table.get(node.var, node.lo, id)
+                                : table.get(node.var, id, node.hi);
+        }
+        root = id;
+        if (root < 0) break;
+    }
+    if (root < 0) {
+        zdd.nodes.clear();
+        return;
+    }
+    // 根节点须为最后一个节点，reduce_zdd 合并其副本并删除不可到达的节点
+    nodes.push_back(nodes[root]);
+    zdd.nodes.swap(nodes);
+    reduce_zdd(zdd);
+}
+
+void sort_nodes_by_var(RawZdd &zdd) {
+    vector<RawNode> &nodes = zdd.nodes;
+    uint32_t max_var = zdd.num_var;
+    for (const RawNode &node : nodes) max_var = max(max_var, node.var);
+    vector<size_t> var_begin(max_var + 2, 0);
+    for (const RawNode &node : nodes) var_begin[node.var]++;
+    size_t pos = 0;
+    for (size_t v = max_var + 1; v-- > 0;) {
+        const size_t count = var_begin[v];
+        var_begin[v] = pos;
+        pos += count;
+    }
+    vector<int64_t> new_id(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+        new_id[i] = var_begin[nodes[i].var]++;
+    }
+    vector<RawNode> sorted(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+        RawNode node = nodes[i];
+        if (node.hi >= 0) node.hi = new_id[node.hi];
+        if (node.lo >= 0) node.lo = new_id[node.lo];
+        sorted[new_id[i]] = node;
+    }
+    nodes.swap(sorted);
+}
+
+void renumber_for_locality(RawZdd &zdd) {
+    const size_t n = zdd.nodes.size();
+    if (n == 0) return;
+
+    // 相同var的节点区间，按文件中的顺序（var降序）
+    vector<pair<size_t, size_t>> levels;
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0 || zdd.nodes[i].var != zdd.nodes[i - 1].var) {
+            levels.emplace_back(i, i);
+        }
+        levels.back().second = i + 1;
+    }
+
+    // 自上而下按父节点的最小位置决定每层内的顺序
+    const size_t unreached = numeric_limits<size_t>::max();
+    vector<size_t> key(n, unreached);
+    vector<size_t> order(n);
+    key[n - 1] = 0;
+    size_t pos = 0;
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+        const auto first = order.begin() + level->first;
+        const auto last = order.begin() + level->second;
+        iota(first, last, level->first);
+        stable_sort(first, last,
+                    [&key](size_t a, size_t b) { return key[a] < key[b]; });
+        for (auto it = first; it != last; ++it) {
+            const RawNode &node = zdd.nodes[*it];
+            if (node.hi >= 0) key[node.hi] = min(key[node.hi], pos);
+            if (node.lo >= 0) key[node.lo] = min(key[node.lo], pos);
+            pos++;
+        }
+    }
+    // 根节点（key为0，排在所在层的最前面）移回最后
+    const auto root_level = order.begin() + levels.back().first;
+    rotate(root_level, root_level + 1, order.end());
+
+    vector<int64_t> new_id(n);
+    for (size_t i = 0; i < n; i++) new_id[order[i]] = i;
+    vector<RawNode> nodes(n);
+    for (size_t i = 0; i < n; i++) {
+        RawNode node = zdd.nodes[order[i]];
+        if (node.hi >= 0) node.hi = new_id[node.hi];
+        if (node.lo >= 0) node.lo = new_id[node.lo];
+        nodes[i] = node;
+    }
+    zdd.nodes.swap(nodes);
+}
+
+count128_t count_zdd_paths(const RawZdd &zdd) {
+    if (zdd.nodes.empty()) return 0;
+
+    vector<count128_t> counts(zdd.nodes.size(), 0);
+    auto child_count = [&counts](int64_t child) -> count128_t {
+        if (child == DD_ONE_TERM) return 1;
+        if (child == DD_ZERO_TERM) return 0;
+        return counts[child];
+    };
+    for (size_t i = 0; i < zdd.nodes.size(); i++) {
+        const RawNode &node = zdd.nodes[i];
+        if (__builtin_add_overflow(child_count(node.hi), child_count(node.lo),
+                                   &counts[i])) {
+            cerr << "error: number of options exceeds 128 bits" << endl;
+            exit(1);
+        }
+    }
+    return counts.back();
+}
+
+SideRows split_unshared_options(RawZdd &zdd, double min_private_ratio,
+                                size_t min_private_nodes) {
+    SideRows rows;
+    vector<RawNode> &nodes = zdd.nodes;
+    const size_t n = nodes.size();
+    if (n == 0) return rows;
+
+    // 根节点lo链上的节点，以及只能经lo链到达的节点
+    vector<int64_t> chain;
+    for (int64_t id = n - 1; id >= 0; id = nodes[id].lo) chain.push_back(id);
+    const int64_t unset = -1, shared = -2;
+    // owner[y]: 可到达y的唯一的lo链节点x（经x的hi边），多个时为shared
+    vector<int64_t> owner(n, unset);
+    // num_paths[y]: 从根节点到y的路径数，2以上记为2
+    vector<uint8_t> num_paths(n, 0);
+    num_paths[n - 1] = 1;
+    vector<bool> on_chain(n, false);
+    for (const int64_t id : chain) on_chain[id] = true;
+    auto merge = [&](int64_t child, int64_t o) {
+        if (child < 0 || o == unset) return;
+        owner[child] = owner[child] == unset || owner[child] == o ? o : shared;
+    };
+    // 父节点在子节点之后，因此从后向前传播
+    for (size_t id = n; id-- > 0;) {
+        const RawNode &node = nodes[id];
+        for (const int64_t child : {node.hi, node.lo}) {
+            if (child >= 0) {
+                num_paths[child] = min(2, num_paths[child] + num_paths[id]);
+            }
+            merge(child, owner[id]);
+        }
+        if (on_chain[id]) merge(node.hi, id);
+    }
+    vector<size_t> num_private(n, 0);
+    for (size_t id = 0; id < n; id++) {
+        if (owner[id] >= 0) num_private[owner[id]]++;
+    }
+
+    // 各节点的集合族的集合数与元素数之和（可能很大，用double）
+    vector<double> num_sets(n), num_elems(n);
+    auto sets_of = [&](int64_t id) {
+        return id >= 0 ? num_sets[id] : id == DD_ONE_TERM ? 1.0 : 0.0;
+    };
+    auto elems_of = [&](int64_t id) { return id >= 0 ? num_elems[id] : 0.0; };
+    for (size_t id = 0; id < n; id++) {
+        const RawNode &node = nodes[id];
+        num_sets[id] = sets_of(node.hi) + sets_of(node.lo);
+        num_elems[id] =
+            elems_of(node.hi) + sets_of(node.hi) + elems_of(node.lo);
+    }
+
+    vector<int64_t> selected;
+    for (const int64_t id : chain) {
+        const RawNode &node = nodes[id];
+        const double num_cells = elems_of(node.hi) + sets_of(node.hi);
+        if (num_paths[id] == 1 && num_private[id] >= min_private_nodes &&
+            num_private[id] >= min_private_ratio * num_cells) {
+            selected.push_back(id);
+        }
+    }
+    if (selected.size() == chain.size()) return rows;
+
+    // 列举移出的选项
+    vector<uint32_t> prefix;
+    auto enumerate = [&](auto &&self, int64_t id) -> void {
+        if (id == DD_ONE_TERM) {
+            rows.elements.insert(rows.elements.end(), prefix.begin(),
+                                 prefix.end());
+            rows.offsets.push_back(rows.elements.size());
+            return;
+        }
+        if (id < 0) return;
+        prefix.push_back(nodes[id].var);
+        self(self, nodes[id].hi);
+        prefix.pop_back();
+        self(self, nodes[id].lo);
+    };
+    for (const int64_t id : selected) {
+        prefix.assign(1, nodes[id].var);
+        enumerate(enumerate, nodes[id].hi);
+        nodes[id].hi = DD_ZERO_TERM;
+    }
+    reduce_zdd(zdd);
+    return rows;
+}
+
+int required_count_bits(const RawZdd &zdd, uint64_t num_rows) {
+    const count128_t num_paths = count_zdd_paths(zdd) + num_rows;
+    if (num_paths <= UINT32_MAX) return 32;
+    if (num_paths <= UINT64_MAX) return 64;
+    return 128;
+}
+
+bool requires_wide_index(const RawZdd &zdd) {
+    return zdd.nodes.size() > ZddTraits<uint32_t, int32_t>::max_nodes;
+}
+
+bool requires_wide_vars(const RawZdd &zdd) {
+    return (uint64_t)zdd.num_var > ZddTraits<uint32_t>::max_vars;
+}
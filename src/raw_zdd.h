@@ -0,0 +1,178 @@
+#ifndef RAW_ZDD_H_
+#define RAW_ZDD_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dancing_on_zdd.h"
+
+/**
+ * A ZDD before dancing links are set up.
+ * Nodes are stored in the order of Graphillion dumps: nodes having the same var
+ * are contiguous, children precede their parents, and the root is the last
+ * node. hi / lo are node ids in this order or DD_ONE_TERM / DD_ZERO_TERM.
+ * 尚未建立舞动链接的ZDD。
+ * 节点按Graphillion输出的顺序存储：相同var的节点连续，子节点在父节点之前，根节点在最后。
+ */
+struct RawNode {
+    uint32_t var;
+    int64_t hi;
+    int64_t lo;
+};
+
+/**
+ * a column covered between lower and upper times (multiplicity).
+ * 被覆盖的次数在 lower 与 upper 之间的列。
+ */
+struct ColumnBounds {
+    uint32_t column;
+    uint32_t lower;
+    uint32_t upper;
+};
+
+struct RawZdd {
+    int num_var = 0;  // largest var appearing in the nodes
+    std::vector<RawNode> nodes;
+    // secondary columns (covered at most once) in ascending order; the other
+    // columns are primary (covered exactly once)
+    std::vector<uint32_t> secondary;
+    // columns covered other than exactly once or at most once, in ascending
+    // order; the columns whose lower bound is 0 are also in secondary
+    std::vector<ColumnBounds> bounds;
+};
+
+/**
+ * options kept as plain dancing-links rows besides the ZDD.
+ * 在ZDD之外以普通舞动链接行保存的选项。
+ */
+struct SideRows {
+    // columns of all rows; the columns of a row are in ascending order
+    std::vector<uint32_t> elements;
+    // row k is elements[offsets[k] .. offsets[k + 1])
+    std::vector<uint64_t> offsets{0};
+
+    size_t num_rows() const { return offsets.size() - 1; }
+};
+
+/**
+ * @brief 读取Graphillion格式的ZDD文件。
+ * @param file_name ZDD文件名。可以是gzip或zstd压缩的文件，此时边解压边解析。
+ * @return 读取的ZDD。
+ */
+RawZdd read_zdd_file(const std::string &file_name);
+
+/**
+ * @brief 以Graphillion的格式写入ZDD文件。
+ * @param zdd 按Graphillion输出的顺序排列的ZDD。
+ * @param file_name 输出的文件名。节点id为 zdd.nodes 中的下标。
+ */
+void write_zdd_file(const RawZdd &zdd, const std::string &file_name);
+
+/**
+ * @brief 检查ZDD的结构并约简。
+ * @param zdd 读取的ZDD，原地修改。根节点为最后一个节点，其他节点的顺序不限。
+ * @return 删除的节点数。
+ * @details var为0的节点，或子节点的var不大于自己的var时报错并退出。
+ *          按var降序（子节点总在父节点之前）经 (var, lo, hi) 的唯一表重建：
+ *          合并同构的节点，删除hi指向⊥的节点，并删除从根节点不可到达的节点。
+ *          结果按Graphillion输出的顺序排列。时间与节点数成线性。
+ */
+size_t reduce_zdd(RawZdd &zdd);
+
+/**
+ * @brief 读取声明次要列的文件。
+ * @param file_name 文件名。各行列出若干列号，'#' 之后为注释。
+ * @return 升序且不重复的列号。列号不是正整数时报错并退出。
+ * @details 次要列至多被覆盖一次，其他列（主列）恰好被覆盖一次。
+ *          ZDD文件 zdd_file 的次要列按惯例在 zdd_file.secondary 中声明。
+ */
+std::vector<uint32_t> read_secondary_columns(const std::string &file_name);
+
+/**
+ * @brief 读取声明列的覆盖次数上下界的文件。
+ * @param file_name 文件名。各行为"列 下界 上界"，'#' 之后为注释。
+ * @return 按列升序的上下界。格式错误、下界大于上界或上界为0时报错并退出。
+ * @details ZDD文件 zdd_file 的上下界按惯例在 zdd_file.bounds 中声明。
+ */
+std::vector<ColumnBounds> read_column_bounds(const std::string &file_name);
+
+/**
+ * @brief 删除只包含次要列的选项。
+ * @param zdd 约简的ZDD，原地修改并重新约简。次要列见 zdd.secondary。
+ * @details 搜索只在主列上分支，不会选择这样的选项，前沿动态规划则需要先删除它们。
+ *          没有剩下的选项时 zdd.nodes 为空。
+ */
+void remove_secondary_only_options(RawZdd &zdd);
+
+/**
+ * @brief 从ZDD表示的集合族中删除给定的选项。
+ * @param zdd 约简的ZDD，原地修改并重新约简。
+ * @param options 要删除的选项，各选项的列升序。不在集合族中的选项被忽略。
+ * @details 每个选项只重建其路径上的节点，时间与选项数乘以路径长度成正比，
+ *          最后的 reduce_zdd 与节点数成线性。没有剩下的选项时 zdd.nodes 为空。
+ */
+void remove_options(RawZdd &zdd,
+                    const std::vector<std::vector<uint32_t>> &options);
+
+/**
+ * @brief 为提高缓存局部性重新排列节点编号。
+ * @param zdd 要重新编号的ZDD，原地修改。
+ * @details 保持Graphillion输出的顺序约束（相同var的节点连续、var降序、根节点在最后），
+ *          只改变同一var内的节点顺序：从根节点开始自上而下，按父节点中最小的新位置排序，
+ *          使父节点相邻的节点也相邻，从而减少向上扫描和枚举时的缓存未命中。
+ */
+void renumber_for_locality(RawZdd &zdd);
+
+/**
+ * @brief 把构建得到的节点按Graphillion输出的顺序重新排列。
+ * @param zdd 节点按创建顺序编号（子节点在父节点之前）且都可从最后创建的根节点到达的ZDD，原地修改。
+ * @details 按var降序排列，相同var内保持原来的顺序。根节点是var最小的唯一节点，因此仍在最后。
+ */
+void sort_nodes_by_var(RawZdd &zdd);
+
+/**
+ * @brief 计算从根节点到⊤终端的路径数，即选项的数量。
+ * @param zdd 输入的ZDD。
+ * @return 路径数。超过128位时报错并退出。
+ * @details 所有计数（count_upper、count_hi、count_lo、列计数）都不超过该值。
+ */
+count128_t count_zdd_paths(const RawZdd &zdd);
+
+/**
+ * @brief 把共享程度低的选项从ZDD中移出，作为普通的行。
+ * @param zdd 约简的ZDD，原地修改并重新约简。
+ * @param min_private_ratio 移出的阈值，见 details。
+ * @param min_private_nodes 移出的一组选项至少要有的私有节点数。
+ * @return 移出的选项，按最小列的顺序排列。
+ * @details 以列c为最小列的选项是根节点lo链上c的节点x的hi边下的集合族。
+ *          只从x的hi边可到达的节点（私有节点）的数量达到这些选项的列数之和的
+ *          min_private_ratio 倍且不少于 min_private_nodes 时，这些选项几乎没有共享后缀，
+ *          把x的hi边改为⊥并移出它们。x须只能经lo链到达。若所有选项都会被移出，则不移出任何选项。
+ */
+SideRows split_unshared_options(RawZdd &zdd, double min_private_ratio,
+                                size_t min_private_nodes);
+
+/**
+ * @brief 选择能保存该ZDD所有计数的最小计数位宽。
+ * @param zdd 输入的ZDD。
+ * @param num_rows 在ZDD之外另有的选项数（见 SideRows），计入列计数。
+ * @return 32、64或128。
+ */
+int required_count_bits(const RawZdd &zdd, uint64_t num_rows = 0);
+
+/**
+ * @brief 判断该ZDD是否需要64位的节点id和父链接。
+ * @param zdd 输入的ZDD。
+ * @return 节点数超过32位父链接可表示的范围时返回 true。
+ */
+bool requires_wide_index(const RawZdd &zdd);
+
+/**
+ * @brief 判断该ZDD是否需要32位的变量（列）编号。
+ * @param zdd 输入的ZDD。
+ * @return 变量数超过16位列头链接可表示的范围时返回 true。
+ */
+bool requires_wide_vars(const RawZdd &zdd);
+
+#endif  // RAW_ZDD_H_
@@ -0,0 +1,176 @@
+#include "reorder.h"
+
+#include <algorithm>
+
+using namespace std;
+
+ZddReorderer::ZddReorderer(const RawZdd &zdd)
+    : tables_(zdd.num_var + 1),
+      var_at_level_(zdd.num_var),
+      level_of_var_(zdd.num_var + 1, 0),
+      root_(zdd.nodes.empty() ? DD_ZERO_TERM : zdd.nodes.size() - 1) {
+    for (int v = 1; v <= zdd.num_var; v++) {
+        var_at_level_[v - 1] = v;
+        level_of_var_[v] = v - 1;
+    }
+    nodes_.resize(zdd.nodes.size());
+    for (size_t i = 0; i < zdd.nodes.size(); i++) {
+        const RawNode &node = zdd.nodes[i];
+        nodes_[i] = {node.var, 0, node.hi, node.lo};
+        tables_[node.var].emplace(make_pair(node.lo, node.hi), i);
+    }
+    for (const Node &node : nodes_) {
+        ref(node.hi);
+        ref(node.lo);
+    }
+    ref(root_);
+    num_live_ = nodes_.size();
+}
+
+void ZddReorderer::deref(int64_t id) {
+    if (id < 0 || --nodes_[id].ref > 0) return;
+    const Node node = nodes_[id];
+    tables_[node.var].erase(make_pair(node.lo, node.hi));
+    free_ids_.push_back(id);
+    num_live_--;
+    deref(node.hi);
+    deref(node.lo);
+}
+
+int64_t ZddReorderer::find_or_add(uint32_t var, int64_t lo, int64_t hi) {
+    if (hi == DD_ZERO_TERM) {
+        ref(lo);
+        return lo;
+    }
+    auto it = tables_[var].find(make_pair(lo, hi));
+    if (it != tables_[var].end()) {
+        ref(it->second);
+        return it->second;
+    }
+    int64_t id;
+    if (free_ids_.empty()) {
+        id = nodes_.size();
+        nodes_.emplace_back();
+    } else {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+    }
+    nodes_[id] = {var, 1, hi, lo};
+    ref(hi);
+    ref(lo);
+    tables_[var].emplace(make_pair(lo, hi), id);
+    num_live_++;
+    return id;
+}
+
+void ZddReorderer::swap_levels(size_t level) {
+    const uint32_t x = var_at_level_[level], y = var_at_level_[level + 1];
+    num_swaps_++;
+    // 不依赖y的x节点保持不变，只是移到下一层
+    Level old_x;
+    old_x.swap(tables_[x]);
+    vector<int64_t> moving;
+    for (const auto &[key, id] : old_x) {
+        if (var_of(nodes_[id].hi) == y || var_of(nodes_[id].lo) == y) {
+            moving.push_back(id);
+        } else {
+            tables_[x].emplace(key, id);
+        }
+    }
+    Level().swap(old_x);
+
+    // u = x ? (y ? f11 : f10) : (y ? f01 : f00) 改写为
+    // u = y ? (x ? f11 : f01) : (x ? f10 : f00)
+    for (const int64_t id : moving) {
+        const int64_t f1 = nodes_[id].hi, f0 = nodes_[id].lo;
+        int64_t f11 = DD_ZERO_TERM, f10 = f1, f01 = DD_ZERO_TERM, f00 = f0;
+        if (var_of(f1) == y) {
+            f11 = nodes_[f1].hi;
+            f10 = nodes_[f1].lo;
+        }
+        if (var_of(f0) == y) {
+            f01 = nodes_[f0].hi;
+            f00 = nodes_[f0].lo;
+        }
+        // 先增加新子节点的引用再释放旧的，避免共享的子节点被提前释放
+        const int64_t hi = find_or_add(x, f01, f11);
+        const int64_t lo = find_or_add(x, f00, f10);
+        deref(f1);
+        deref(f0);
+        // u依赖y，所以hi不为⊥；新的y节点有x的子节点，不会与原有的y节点相同
+        nodes_[id].var = y;
+        nodes_[id].hi = hi;
+        nodes_[id].lo = lo;
+        tables_[y].emplace(make_pair(lo, hi), id);
+    }
+    swap(var_at_level_[level], var_at_level_[level + 1]);
+    level_of_var_[x] = level + 1;
+    level_of_var_[y] = level;
+}
+
+void ZddReorderer::move_var(size_t from, size_t to) {
+    for (; from < to; from++) swap_levels(from);
+    for (; from > to; from--) swap_levels(from - 1);
+}
+
+void ZddReorderer::sift(double max_growth, size_t max_vars) {
+    const size_t num_levels = var_at_level_.size();
+    vector<uint32_t> vars(var_at_level_);
+    stable_sort(vars.begin(), vars.end(), [&](uint32_t a, uint32_t b) {
+        return tables_[a].size() > tables_[b].size();
+    });
+    vars.resize(min(vars.size(), max_vars));
+    for (const uint32_t v : vars) {
+        if (tables_[v].empty()) continue;
+        size_t level = level_of_var_[v];
+        size_t best_size = num_live_, best_level = level;
+        auto try_move = [&](size_t to) {
+            move_var(level, to);
+            level = to;
+            if (num_live_ < best_size) {
+                best_size = num_live_;
+                best_level = level;
+            }
+            return num_live_ <= max_growth * best_size;
+        };
+        // 先向较近的一端移动，再向另一端，最后回到最好的位置
+        const bool down_first = level >= num_levels / 2;
+        for (int pass = 0; pass < 2; pass++) {
+            if ((pass == 0) == down_first) {
+                while (level + 1 < num_levels && try_move(level + 1)) {
+                }
+            } else {
+                while (level > 0 && try_move(level - 1)) {
+                }
+            }
+        }
+        move_var(level, best_level);
+    }
+}
+
+RawZdd ZddReorderer::reordered(vector<uint32_t> &column_map) const {
+    const size_t num_levels = var_at_level_.size();
+    column_map.assign(num_levels + 1, 0);
+    for (size_t p = 0; p < num_levels; p++) column_map[p + 1] = var_at_level_[p];
+
+    RawZdd zdd;
+    zdd.num_var = num_levels;
+    if (root_ < 0) return zdd;
+    // 自下而上逐层输出，根节点是最上面的存活层的唯一节点
+    vector<int64_t> new_id(nodes_.size(), -1);
+    auto map_id = [&](int64_t id) { return id < 0 ? id : new_id[id]; };
+    for (size_t p = num_levels; p-- > 0;) {
+        const uint32_t var = var_at_level_[p];
+        vector<int64_t> ids;
+        ids.reserve(tables_[var].size());
+        for (const auto &entry : tables_[var]) ids.push_back(entry.second);
+        sort(ids.begin(), ids.end());
+        for (const int64_t id : ids) {
+            const Node &node = nodes_[id];
+            new_id[id] = zdd.nodes.size();
+            zdd.nodes.push_back({(uint32_t)p + 1, map_id(node.hi),
+                                 map_id(node.lo)});
+        }
+    }
+    return zdd;
+}
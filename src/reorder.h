@@ -0,0 +1,93 @@
+#ifndef REORDER_H_
+#define REORDER_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "raw_zdd.h"
+
+/**
+ * Variable reordering of a ZDD by in-place swaps of adjacent levels.
+ * Level 0 is the top (root side). A swap of levels p and p + 1 rewrites only
+ * the nodes of level p: nodes that depend on the variable below are turned
+ * into nodes of that variable, keeping their ids, so parents above stay
+ * valid; nodes of the lower variable that lose all parents are freed with
+ * reference counting. The cost of a swap is proportional to the two levels.
+ * 以相邻层的原地交换进行ZDD的变量重排序。第0层为最上层（根节点一侧）。
+ * 交换第p层和第p+1层时只改写第p层的节点：依赖下一层变量的节点原地变为该变量的节点（id不变），
+ * 因此上层的父节点无需修改；失去所有父节点的节点按引用计数释放。
+ */
+class ZddReorderer {
+   public:
+    /**
+     * @param zdd 约简的ZDD（见 reduce_zdd）。
+     */
+    explicit ZddReorderer(const RawZdd &zdd);
+
+    // 存活的节点数
+    size_t size() const { return num_live_; }
+    // 已进行的交换次数
+    size_t num_swaps() const { return num_swaps_; }
+
+    /**
+     * @brief 交换第 level 层和第 level + 1 层的变量。
+     */
+    void swap_levels(size_t level);
+
+    /**
+     * @brief Rudell的筛选法：依次把每个变量移动到使节点数最小的层。
+     * @param max_growth 节点数超过目前最小值的 max_growth 倍时停止向该方向移动。
+     * @param max_vars 最多处理的变量数，按所在层的节点数从多到少选择。
+     */
+    void sift(double max_growth, size_t max_vars);
+
+    /**
+     * @brief 按当前的变量顺序输出ZDD。
+     * @param column_map 输出新变量到原变量的映射：新变量 i（第 i - 1 层）为原变量 column_map[i]。
+     * @return 按Graphillion输出的顺序排列的ZDD，变量按层重新编号。
+     */
+    RawZdd reordered(std::vector<uint32_t> &column_map) const;
+
+   private:
+    struct Node {
+        uint32_t var;
+        uint32_t ref;  // 父节点的引用数（根节点另加1）
+        int64_t hi;
+        int64_t lo;
+    };
+
+    struct ChildHash {
+        size_t operator()(const std::pair<int64_t, int64_t> &key) const {
+            uint64_t h = (uint64_t)key.first * 0x9e3779b97f4a7c15ULL;
+            h ^= (uint64_t)key.second + (h << 6) + (h >> 2);
+            h *= 0xbf58476d1ce4e5b9ULL;
+            return h ^ (h >> 31);
+        }
+    };
+    // 一个变量的唯一表：(lo, hi) -> 节点id
+    using Level =
+        std::unordered_map<std::pair<int64_t, int64_t>, int64_t, ChildHash>;
+
+    uint32_t var_of(int64_t id) const { return id < 0 ? 0 : nodes_[id].var; }
+    void ref(int64_t id) {
+        if (id >= 0) nodes_[id].ref++;
+    }
+    void deref(int64_t id);
+    // 获取 (var, lo, hi) 的节点并增加其引用数，不存在时创建
+    int64_t find_or_add(uint32_t var, int64_t lo, int64_t hi);
+    // 把变量从 from 层逐层移动到 to 层
+    void move_var(size_t from, size_t to);
+
+    std::vector<Node> nodes_;
+    std::vector<int64_t> free_ids_;
+    std::vector<Level> tables_;  // 按变量索引
+    std::vector<uint32_t> var_at_level_;
+    std::vector<uint32_t> level_of_var_;
+    int64_t root_;
+    size_t num_live_ = 0;
+    size_t num_swaps_ = 0;
+};
+
+#endif  // REORDER_H_
@@ -0,0 +1,65 @@
+// randomized check of level swaps and sifting against the original family
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#include "raw_zdd.h"
+#include "reorder.h"
+#include "test_util.h"
+
+/**
+ * @brief 检查重新排序后的ZDD：经 column_map 映射回原变量后集合族与 original 相同，
+ *        且为约简的ZDD，节点数与 ZddReorderer::size 相同。
+ */
+void check_reordered(const ZddReorderer &reorderer, const Family &original,
+                     const char *what, uint64_t seed, int &num_failures) {
+    vector<uint32_t> column_map;
+    RawZdd zdd = reorderer.reordered(column_map);
+    Family mapped;
+    for (const vector<uint32_t> &set : enumerate_family(zdd)) {
+        vector<uint32_t> orig;
+        for (const uint32_t var : set) orig.push_back(column_map[var]);
+        sort(orig.begin(), orig.end());
+        mapped.insert(orig);
+    }
+    check(mapped == original, what, seed, num_failures);
+    check(zdd.nodes.size() == reorderer.size(), "size after reordering", seed,
+          num_failures);
+    check(reduce_zdd(zdd) == 0, "reordered zdd is reduced", seed,
+          num_failures);
+}
+
+/**
+ * 随机生成集合族，在其ZDD上进行随机的相邻层交换和筛选，
+ * 检查经变量映射还原后的集合族与原来的相同、结果为约简的ZDD，且筛选不增加节点数。
+ * usage: ./reorder_test [num_seeds]
+ */
+int main(int argc, char **argv) {
+    const int num_seeds = argc > 1 ? atoi(argv[1]) : 2000;
+    int num_failures = 0;
+    for (int seed = 0; seed < num_seeds; seed++) {
+        std::mt19937_64 rng(seed);
+        const int num_var = 2 + rng() % 9;
+        const Family family = random_family(rng, num_var, 40);
+        if (family.empty()) continue;
+        const RawZdd zdd = build_family_zdd(family, num_var);
+
+        ZddReorderer swapped(zdd);
+        const int num_swaps = rng() % 20;
+        for (int k = 0; k < num_swaps; k++) {
+            swapped.swap_levels(rng() % (num_var - 1));
+        }
+        check_reordered(swapped, family, "family after level swaps", seed,
+                        num_failures);
+
+        ZddReorderer sifted(zdd);
+        sifted.sift(1 + (double)(rng() % 3) / 2, num_var);
+        check_reordered(sifted, family, "family after sifting", seed,
+                        num_failures);
+        check(sifted.size() <= zdd.nodes.size(), "sifting does not grow",
+              seed, num_failures);
+    }
+    printf("%d families, %d failures\n", num_seeds, num_failures);
+    return num_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+// search-time benchmark of ZDD files
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "dancing_on_zdd.h"
+#include "dp_manager.h"
+#include "raw_zdd.h"
+
+/**
+ * 在同一个结构上重复搜索，返回各次搜索的时间（毫秒）
+ * @param zdd 约简的ZDD。
+ * @param repeats 搜索次数。
+ * @details 搜索结束后结构已恢复，因此不重新加载。更新次数等计数器每次清零。
+ */
+template <typename Traits>
+vector<double> time_search(const RawZdd &zdd, int repeats) {
+    using clock = std::chrono::steady_clock;
+    ZddWithLinks<Traits> zdd_with_links(zdd.num_var);
+    zdd_with_links.load_zdd(zdd);
+    vector<vector<typename Traits::var_t>> solution;
+    vector<double> times;
+    for (int r = 0; r < repeats; r++) {
+        ZddWithLinks<Traits>::num_search_tree_nodes = 0;
+        ZddWithLinks<Traits>::num_solutions = 0;
+        ZddWithLinks<Traits>::num_updates = 0;
+        const auto t0 = clock::now();
+        zdd_with_links.search(solution, 0);
+        const auto t1 = clock::now();
+        times.push_back(
+            std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    printf("  %s solutions, %llu search tree nodes, %llu updates\n",
+           count_to_string(ZddWithLinks<Traits>::num_solutions).c_str(),
+           (unsigned long long)ZddWithLinks<Traits>::num_search_tree_nodes,
+           (unsigned long long)ZddWithLinks<Traits>::num_updates);
+    return times;
+}
+
+/**
+ * 对每个ZDD文件测量搜索（search）的时间，用于检查搜索路径的性能回归。
+ * 位宽与 d3x 的默认值相同（64位计数，必要时使用64位节点id和32位变量编号），
+ * 不使用前沿动态规划和ZDD之外的行。
+ * usage: ./search_bench [-n repeats] zdd_file...
+ */
+int main(int argc, char **argv) {
+    int repeats = 3;
+    int first = 1;
+    if (argc > 2 && string(argv[1]) == "-n") {
+        repeats = atoi(argv[2]);
+        first = 3;
+    }
+    if (first >= argc || repeats < 1) {
+        cerr << "usage: ./search_bench [-n repeats] zdd_file..." << endl;
+        exit(1);
+    }
+
+    for (int f = first; f < argc; f++) {
+        RawZdd zdd = read_zdd_file(argv[f]);
+        reduce_zdd(zdd);
+        printf("%s: %zu nodes\n", argv[f], zdd.nodes.size());
+        vector<double> times =
+            requires_wide_index(zdd) || requires_wide_vars(zdd)
+                ? time_search<ZddTraits<uint64_t, int64_t, uint32_t>>(
+                      zdd, repeats)
+                : time_search<ZddTraits<uint64_t, int32_t, uint16_t>>(
+                      zdd, repeats);
+        sort(times.begin(), times.end());
+        printf("  search best %.1f msecs, median %.1f msecs (%d runs)\n",
+               times.front(), times[times.size() / 2], repeats);
+    }
+    return 0;
+}
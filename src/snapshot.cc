@@ -0,0 +1,33 @@
+#include "snapshot.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+SnapshotHeader read_snapshot_header(const string &file_name) {
+    ifstream ifs(file_name, ios::binary);
+    if (!ifs) {
+        cerr << "can't open " << file_name << endl;
+        exit(1);
+    }
+    SnapshotHeader header;
+    if (!ifs.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        cerr << file_name << " is not a d3x snapshot" << endl;
+        exit(1);
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        cerr << file_name << " has snapshot version " << header.version
+             << ", expected " << SNAPSHOT_VERSION << endl;
+        exit(1);
+    }
+    ifs.seekg(0, ios::end);
+    if ((uint64_t)ifs.tellg() < SNAPSHOT_DATA_OFFSET + header.data_bytes) {
+        cerr << file_name << " is truncated" << endl;
+        exit(1);
+    }
+    return header;
+}
@@ -0,0 +1,41 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Binary snapshot of a ZddWithLinks after setup_dancing_links.
+ * The file starts with a SnapshotHeader padded to SNAPSHOT_DATA_OFFSET,
+ * followed by the header cells and the node table arrays (hot fields,
+ * parent links, up links), each aligned to 64 bytes in the same
+ * layout the Arena bump allocator produces. Loading maps the file once
+ * with MAP_PRIVATE, so the arrays are used in place and pages are copied
+ * only when the search writes them.
+ * 建立舞动链接后的ZddWithLinks的二进制快照。
+ * 文件由填充到 SNAPSHOT_DATA_OFFSET 的 SnapshotHeader 和按64字节对齐的各数组组成，
+ * 布局与Arena顺序分配的结果相同，因此以MAP_PRIVATE映射后可以直接使用。
+ */
+constexpr char SNAPSHOT_MAGIC[8] = {'D', '3', 'X', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t SNAPSHOT_VERSION = 3;
+constexpr uint64_t SNAPSHOT_DATA_OFFSET = 4096;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count_bytes;  // sizeof(count_t)
+    uint32_t index_bytes;  // sizeof(index_t)
+    uint32_t var_bytes;    // sizeof(var_t)
+    uint64_t num_var;
+    uint64_t num_nodes;
+    uint64_t data_bytes;  // SNAPSHOT_DATA_OFFSET 之后的字节数
+};
+
+/**
+ * @brief 读取并检查快照文件的头部。
+ * @param file_name 快照文件名。
+ * @return 快照的头部。文件不是有效的快照时报错并退出。
+ */
+SnapshotHeader read_snapshot_header(const std::string &file_name);
+
+#endif  // SNAPSHOT_H_
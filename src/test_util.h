@@ -0,0 +1,102 @@
+#ifndef TEST_UTIL_H_
+#define TEST_UTIL_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "option_list.h"
+#include "raw_zdd.h"
+
+/**
+ * helpers of the randomized checks (ctest): set families kept as std::set
+ * and converted from / to RawZdd.
+ * 随机检查（ctest）使用的辅助函数：以std::set表示集合族，与RawZdd相互转换。
+ */
+
+// 集合族，各集合的元素（变量）升序
+using Family = std::set<std::vector<uint32_t>>;
+
+/**
+ * @brief 检查条件，不满足时输出信息并计数。
+ * @return 条件是否满足。
+ */
+inline bool check(bool condition, const char *what, uint64_t seed,
+                  int &num_failures) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s (seed %llu)\n", what,
+                (unsigned long long)seed);
+        num_failures++;
+    }
+    return condition;
+}
+
+/**
+ * @brief 列举ZDD表示的集合族。
+ * @param zdd 按Graphillion输出的顺序排列的ZDD，节点为空时为空族。
+ */
+inline Family enumerate_family(const RawZdd &zdd) {
+    Family family;
+    if (zdd.nodes.empty()) return family;
+    std::vector<uint32_t> path;
+    auto walk = [&](auto &&self, int64_t id) -> void {
+        if (id == DD_ZERO_TERM) return;
+        if (id == DD_ONE_TERM) {
+            std::vector<uint32_t> set = path;
+            std::sort(set.begin(), set.end());
+            family.insert(set);
+            return;
+        }
+        const RawNode &node = zdd.nodes[id];
+        self(self, node.lo);
+        path.push_back(node.var);
+        self(self, node.hi);
+        path.pop_back();
+    };
+    walk(walk, (int64_t)zdd.nodes.size() - 1);
+    return family;
+}
+
+/**
+ * @brief 由集合族构建约简的ZDD（见 build_zdd_from_options）。
+ * @param family 非空集合的族，元素为 1 .. num_var。
+ * @param num_var 变量数。
+ */
+inline RawZdd build_family_zdd(const Family &family, int num_var) {
+    OptionList options;
+    for (int i = 1; i <= num_var; i++) {
+        options.items.push_back(std::to_string(i));
+    }
+    options.num_primary = num_var;
+    for (const std::vector<uint32_t> &set : family) {
+        for (const uint32_t var : set) options.elements.push_back(var - 1);
+        options.offsets.push_back(options.elements.size());
+    }
+    size_t num_duplicates;
+    return build_zdd_from_options(options, num_duplicates);
+}
+
+/**
+ * @brief 随机的集合族：至多 max_sets 个 1 .. num_var 的非空子集。
+ */
+inline Family random_family(std::mt19937_64 &rng, int num_var,
+                            size_t max_sets) {
+    Family family;
+    const size_t num_sets = rng() % (max_sets + 1);
+    for (size_t k = 0; k < num_sets; k++) {
+        std::vector<uint32_t> set;
+        while (set.empty()) {
+            for (int var = 1; var <= num_var; var++) {
+                if (rng() % 3 == 0) set.push_back(var);
+            }
+        }
+        family.insert(set);
+    }
+    return family;
+}
+
+#endif  // TEST_UTIL_H_
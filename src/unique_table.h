@@ -0,0 +1,77 @@
+#ifndef UNIQUE_TABLE_H_
+#define UNIQUE_TABLE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "raw_zdd.h"
+
+/**
+ * hash-consed table of ZDD nodes keyed by (var, lo, hi).
+ * 以 (var, lo, hi) 为键的ZDD节点唯一表，开放寻址。
+ */
+class UniqueTable {
+   public:
+    explicit UniqueTable(std::vector<RawNode> &nodes)
+        : nodes_(nodes), slots_(1024, -1), mask_(1023) {}
+
+    /**
+     * @brief 获取 (var, lo, hi) 的节点，不存在时创建。
+     * @return 节点id（创建的顺序）或终端。hi为⊥时返回lo（零压缩规则）。
+     */
+    int64_t get(uint32_t var, int64_t lo, int64_t hi) {
+        if (hi == DD_ZERO_TERM) return lo;
+        for (size_t s = hash(var, lo, hi) & mask_;; s = (s + 1) & mask_) {
+            const int64_t id = slots_[s];
+            if (id < 0) break;
+            const RawNode &node = nodes_[id];
+            if (node.var == var && node.lo == lo && node.hi == hi) return id;
+        }
+        const int64_t id = nodes_.size();
+        nodes_.push_back({var, hi, lo});
+        if (2 * nodes_.size() > slots_.size()) {
+            rehash(2 * slots_.size());
+        } else {
+            insert(id);
+        }
+        return id;
+    }
+
+    /**
+     * @brief 预先扩大表，使创建 n 个节点之前不需要重新散列。
+     */
+    void reserve(size_t n) {
+        size_t size = slots_.size();
+        while (size < 2 * n) size *= 2;
+        if (size > slots_.size()) rehash(size);
+    }
+
+   private:
+    static size_t hash(uint32_t var, int64_t lo, int64_t hi) {
+        uint64_t h = var * 0x9e3779b97f4a7c15ULL;
+        h ^= (uint64_t)lo + 0x632be59bd9b4e019ULL + (h << 6) + (h >> 2);
+        h ^= (uint64_t)hi + 0x85157af5ULL + (h << 6) + (h >> 2);
+        h ^= h >> 31;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        return h ^ (h >> 29);
+    }
+
+    void insert(int64_t id) {
+        const RawNode &node = nodes_[id];
+        size_t s = hash(node.var, node.lo, node.hi) & mask_;
+        while (slots_[s] >= 0) s = (s + 1) & mask_;
+        slots_[s] = id;
+    }
+
+    void rehash(size_t size) {
+        slots_.assign(size, -1);
+        mask_ = size - 1;
+        for (size_t id = 0; id < nodes_.size(); id++) insert(id);
+    }
+
+    std::vector<RawNode> &nodes_;
+    std::vector<int64_t> slots_;
+    size_t mask_;
+};
+
+#endif  // UNIQUE_TABLE_H_
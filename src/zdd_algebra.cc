@@ -0,0 +1,333 @@
+#include "zdd_algebra.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+// 运算缓存的初始条目数
+constexpr size_t MIN_CACHE_ENTRIES = 1 << 10;
+
+/**
+ * recursive descent parser of set expressions, evaluated while parsing.
+ * 集合表达式的递归下降解析器，边解析边计算。
+ *   expr   := term (('|' | '-') term)*
+ *   term   := factor ('&' factor)*
+ *   factor := 'z' N | '(' expr ')' | ('onset' | 'offset') '(' expr ',' N ')'
+ *           | 'restrict' '(' expr ',' expr ')'
+ */
+class ExpressionParser {
+   public:
+    ExpressionParser(ZddAlgebra &algebra, const string &text,
+                     const vector<int64_t> &operands)
+        : algebra_(algebra), text_(text), operands_(operands) {}
+
+    int64_t parse() {
+        const int64_t f = expr();
+        skip_spaces();
+        if (pos_ != text_.size()) error("unexpected character");
+        return f;
+    }
+
+   private:
+    int64_t expr() {
+        int64_t f = term();
+        for (;;) {
+            if (accept('|')) {
+                f = algebra_.unite(f, term());
+            } else if (accept('-')) {
+                f = algebra_.subtract(f, term());
+            } else {
+                return f;
+            }
+        }
+    }
+
+    int64_t term() {
+        int64_t f = factor();
+        while (accept('&')) f = algebra_.intersect(f, factor());
+        return f;
+    }
+
+    int64_t factor() {
+        if (accept('(')) {
+            const int64_t f = expr();
+            expect(')');
+            return f;
+        }
+        const string name = identifier();
+        if (name == "onset" || name == "offset") {
+            expect('(');
+            const int64_t f = expr();
+            expect(',');
+            const uint64_t var = number();
+            expect(')');
+            if (var == 0 || var > UINT32_MAX) error("invalid item");
+            return name == "onset" ? algebra_.onset(f, var)
+                                   : algebra_.offset(f, var);
+        }
+        if (name == "restrict") {
+            expect('(');
+            const int64_t f = expr();
+            expect(',');
+            const int64_t g = expr();
+            expect(')');
+            return algebra_.restrict(f, g);
+        }
+        if (name.size() > 1 && name[0] == 'z' &&
+            all_of(name.begin() + 1, name.end(), ::isdigit)) {
+            const size_t k = stoull(name.substr(1));
+            if (k == 0 || k > operands_.size()) error("no such input " + name);
+            return operands_[k - 1];
+        }
+        error("unknown name '" + name + "'");
+        return DD_ZERO_TERM;
+    }
+
+    string identifier() {
+        skip_spaces();
+        const size_t begin = pos_;
+        while (pos_ < text_.size() && isalnum((unsigned char)text_[pos_])) {
+            pos_++;
+        }
+        if (begin == pos_) error("operand expected");
+        return text_.substr(begin, pos_ - begin);
+    }
+
+    uint64_t number() {
+        skip_spaces();
+        const size_t begin = pos_;
+        while (pos_ < text_.size() && isdigit((unsigned char)text_[pos_])) {
+            pos_++;
+        }
+        if (begin == pos_ || pos_ - begin > 10) error("number expected");
+        return stoull(text_.substr(begin, pos_ - begin));
+    }
+
+    void skip_spaces() {
+        while (pos_ < text_.size() && isspace((unsigned char)text_[pos_])) {
+            pos_++;
+        }
+    }
+
+    bool accept(char c) {
+        skip_spaces();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!accept(c)) error(string("'") + c + "' expected");
+    }
+
+    [[noreturn]] void error(const string &message) const {
+        cerr << "invalid expression at position " << pos_ << ": " << message
+             << endl;
+        exit(1);
+    }
+
+    ZddAlgebra &algebra_;
+    const string &text_;
+    const vector<int64_t> &operands_;
+    size_t pos_ = 0;
+};
+
+}  // namespace
+
+ZddAlgebra::ZddAlgebra(size_t cache_bytes)
+    : table_(nodes_), max_cache_entries_(MIN_CACHE_ENTRIES) {
+    // 不超过字节数上限的最大的2的幂
+    while (max_cache_entries_ * 2 * sizeof(CacheEntry) <= cache_bytes) {
+        max_cache_entries_ *= 2;
+    }
+    cache_.assign(MIN_CACHE_ENTRIES, {~0ULL, 0, 0});
+}
+
+int64_t ZddAlgebra::add(const RawZdd &zdd) {
+    num_var_ = max(num_var_, zdd.num_var);
+    if (zdd.nodes.empty()) return DD_ZERO_TERM;
+    // 子节点在父节点之前，按顺序导入即可
+    vector<int64_t> ids(zdd.nodes.size());
+    auto map_id = [&](int64_t id) { return id < 0 ? id : ids[id]; };
+    for (size_t k = 0; k < zdd.nodes.size(); k++) {
+        const RawNode &node = zdd.nodes[k];
+        ids[k] = table_.get(node.var, map_id(node.lo), map_id(node.hi));
+    }
+    return ids.back();
+}
+
+size_t ZddAlgebra::cache_index(uint64_t key, int64_t g) const {
+    uint64_t h = (key ^ ((uint64_t)g * 0x9e3779b97f4a7c15ULL)) *
+                 0xbf58476d1ce4e5b9ULL;
+    return (h ^ (h >> 31)) & (cache_.size() - 1);
+}
+
+bool ZddAlgebra::cache_lookup(Op op, int64_t f, int64_t g,
+                              int64_t &result) const {
+    const uint64_t key = (uint64_t)f << 3 | op;
+    const CacheEntry &entry = cache_[cache_index(key, g)];
+    if (entry.key != key || entry.operand != g) return false;
+    result = entry.result;
+    return true;
+}
+
+void ZddAlgebra::cache_insert(Op op, int64_t f, int64_t g, int64_t result) {
+    // 节点数超过条目数时扩大缓存（丢弃已有的条目）
+    if (nodes_.size() > cache_.size() && cache_.size() < max_cache_entries_) {
+        size_t size = cache_.size();
+        while (size < nodes_.size() && size < max_cache_entries_) size *= 2;
+        cache_.assign(size, {~0ULL, 0, 0});
+    }
+    const uint64_t key = (uint64_t)f << 3 | op;
+    cache_[cache_index(key, g)] = {key, g, result};
+}
+
+int64_t ZddAlgebra::unite(int64_t f, int64_t g) {
+    if (f == DD_ZERO_TERM) return g;
+    if (g == DD_ZERO_TERM || f == g) return f;
+    if (f > g) swap(f, g);
+    int64_t result;
+    if (cache_lookup(UNION, f, g, result)) return result;
+    const uint32_t vf = top_var(f), vg = top_var(g);
+    if (vf < vg) {
+        const RawNode node = nodes_[f];
+        result = table_.get(vf, unite(node.lo, g), node.hi);
+    } else if (vf > vg) {
+        const RawNode node = nodes_[g];
+        result = table_.get(vg, unite(f, node.lo), node.hi);
+    } else {
+        const RawNode a = nodes_[f], b = nodes_[g];
+        const int64_t lo = unite(a.lo, b.lo);
+        result = table_.get(vf, lo, unite(a.hi, b.hi));
+    }
+    cache_insert(UNION, f, g, result);
+    return result;
+}
+
+int64_t ZddAlgebra::intersect(int64_t f, int64_t g) {
+    if (f == DD_ZERO_TERM || g == DD_ZERO_TERM) return DD_ZERO_TERM;
+    if (f == g) return f;
+    if (f > g) swap(f, g);
+    int64_t result;
+    if (cache_lookup(INTERSECT, f, g, result)) return result;
+    const uint32_t vf = top_var(f), vg = top_var(g);
+    if (vf < vg) {
+        result = intersect(nodes_[f].lo, g);
+    } else if (vf > vg) {
+        result = intersect(f, nodes_[g].lo);
+    } else {
+        const RawNode a = nodes_[f], b = nodes_[g];
+        const int64_t lo = intersect(a.lo, b.lo);
+        result = table_.get(vf, lo, intersect(a.hi, b.hi));
+    }
+    cache_insert(INTERSECT, f, g, result);
+    return result;
+}
+
+int64_t ZddAlgebra::subtract(int64_t f, int64_t g) {
+    if (f == DD_ZERO_TERM || f == g) return DD_ZERO_TERM;
+    if (g == DD_ZERO_TERM) return f;
+    int64_t result;
+    if (cache_lookup(SUBTRACT, f, g, result)) return result;
+    const uint32_t vf = top_var(f), vg = top_var(g);
+    if (vf < vg) {
+        const RawNode node = nodes_[f];
+        result = table_.get(vf, subtract(node.lo, g), node.hi);
+    } else if (vf > vg) {
+        result = subtract(f, nodes_[g].lo);
+    } else {
+        const RawNode a = nodes_[f], b = nodes_[g];
+        const int64_t lo = subtract(a.lo, b.lo);
+        result = table_.get(vf, lo, subtract(a.hi, b.hi));
+    }
+    cache_insert(SUBTRACT, f, g, result);
+    return result;
+}
+
+int64_t ZddAlgebra::onset(int64_t f, uint32_t var) {
+    const uint32_t vf = top_var(f);
+    if (vf > var) return DD_ZERO_TERM;
+    if (vf == var) return table_.get(var, DD_ZERO_TERM, nodes_[f].hi);
+    int64_t result;
+    if (cache_lookup(ONSET, f, var, result)) return result;
+    const RawNode node = nodes_[f];
+    const int64_t lo = onset(node.lo, var);
+    result = table_.get(vf, lo, onset(node.hi, var));
+    cache_insert(ONSET, f, var, result);
+    return result;
+}
+
+int64_t ZddAlgebra::offset(int64_t f, uint32_t var) {
+    const uint32_t vf = top_var(f);
+    if (vf > var) return f;
+    if (vf == var) return nodes_[f].lo;
+    int64_t result;
+    if (cache_lookup(OFFSET, f, var, result)) return result;
+    const RawNode node = nodes_[f];
+    const int64_t lo = offset(node.lo, var);
+    result = table_.get(vf, lo, offset(node.hi, var));
+    cache_insert(OFFSET, f, var, result);
+    return result;
+}
+
+int64_t ZddAlgebra::restrict(int64_t f, int64_t g) {
+    if (f == DD_ZERO_TERM || g == DD_ZERO_TERM) return DD_ZERO_TERM;
+    if (f == g) return f;
+    // 空集是所有集合的子集：沿lo链检查 g 是否包含空集
+    int64_t empty = g;
+    while (empty >= 0) empty = nodes_[empty].lo;
+    if (empty == DD_ONE_TERM) return f;
+    int64_t result;
+    if (cache_lookup(RESTRICT, f, g, result)) return result;
+    const uint32_t vf = top_var(f), vg = top_var(g);
+    if (vf < vg) {
+        const RawNode node = nodes_[f];
+        const int64_t lo = restrict(node.lo, g);
+        result = table_.get(vf, lo, restrict(node.hi, g));
+    } else if (vf > vg) {
+        // f 的选项都不含 vg，g 中含 vg 的选项不可能是其子集
+        result = restrict(f, nodes_[g].lo);
+    } else {
+        const RawNode a = nodes_[f], b = nodes_[g];
+        const int64_t lo = restrict(a.lo, b.lo);
+        const int64_t either = unite(b.lo, b.hi);
+        result = table_.get(vf, lo, restrict(a.hi, either));
+    }
+    cache_insert(RESTRICT, f, g, result);
+    return result;
+}
+
+int64_t ZddAlgebra::evaluate(const string &expression,
+                             const vector<int64_t> &operands) {
+    return ExpressionParser(*this, expression, operands).parse();
+}
+
+RawZdd ZddAlgebra::extract(int64_t root) const {
+    RawZdd zdd;
+    zdd.num_var = num_var_;
+    if (root < 0) return zdd;
+    // 子节点的id总是小于父节点，从根节点向下标记可到达的节点
+    vector<int64_t> ids(root + 1, -1);
+    ids[root] = 0;
+    for (int64_t id = root; id >= 0; id--) {
+        if (ids[id] < 0) continue;
+        const RawNode &node = nodes_[id];
+        if (node.lo >= 0) ids[node.lo] = 0;
+        if (node.hi >= 0) ids[node.hi] = 0;
+    }
+    auto map_id = [&](int64_t id) { return id < 0 ? id : ids[id]; };
+    for (int64_t id = 0; id <= root; id++) {
+        if (ids[id] < 0) continue;
+        const RawNode &node = nodes_[id];
+        ids[id] = zdd.nodes.size();
+        zdd.nodes.push_back({node.var, map_id(node.hi), map_id(node.lo)});
+    }
+    sort_nodes_by_var(zdd);
+    return zdd;
+}
@@ -0,0 +1,117 @@
+#ifndef ZDD_ALGEBRA_H_
+#define ZDD_ALGEBRA_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "raw_zdd.h"
+#include "unique_table.h"
+
+/**
+ * Set operations on ZDDs sharing one node store.
+ * Input ZDDs are imported into the store through a unique table, so equal
+ * sub-ZDDs of different inputs become one node. The operations are the usual
+ * apply-style recursions memoized in an operation cache. The cache is a lossy
+ * direct-mapped table: it grows with the number of nodes up to a byte budget,
+ * and a colliding entry simply overwrites the old one, so the memory of the
+ * cache never exceeds the budget whatever the size of the operands.
+ * All inputs must use the same variable order (var i is item i).
+ * 在同一个节点存储上进行ZDD的集合运算。
+ * 输入的ZDD经唯一表导入，不同输入中相同的子ZDD共享节点。
+ * 运算为带运算缓存的递归。缓存为直接映射的有损表，随节点数增长但不超过给定的字节数，冲突时覆盖旧的条目。
+ */
+class ZddAlgebra {
+   public:
+    /**
+     * @param cache_bytes 运算缓存的字节数上限。
+     */
+    explicit ZddAlgebra(size_t cache_bytes);
+
+    /**
+     * @brief 导入一个ZDD。
+     * @param zdd Graphillion输出顺序的ZDD。
+     * @return 根节点id或终端。节点为空时为⊥。
+     */
+    int64_t add(const RawZdd &zdd);
+
+    /**
+     * @brief 并集 f ∪ g。
+     */
+    int64_t unite(int64_t f, int64_t g);
+
+    /**
+     * @brief 交集 f ∩ g。
+     */
+    int64_t intersect(int64_t f, int64_t g);
+
+    /**
+     * @brief 差集 f \ g。
+     */
+    int64_t subtract(int64_t f, int64_t g);
+
+    /**
+     * @brief 包含项目 var 的选项。
+     * @details 与Minato的定义不同，结果中保留 var，以便直接用于精确覆盖。
+     */
+    int64_t onset(int64_t f, uint32_t var);
+
+    /**
+     * @brief 不包含项目 var 的选项。
+     */
+    int64_t offset(int64_t f, uint32_t var);
+
+    /**
+     * @brief f 中至少包含 g 的一个选项的选项，即 {S ∈ f | ∃T ∈ g, T ⊆ S}。
+     */
+    int64_t restrict(int64_t f, int64_t g);
+
+    /**
+     * @brief 计算表达式。
+     * @param expression 表达式。z1, z2, ... 为 operands 的各元素，
+     *        运算符为 |（并）、-（差）、&（交，优先级高于 | 和 -），
+     *        函数为 onset(e, var)、offset(e, var)、restrict(e, e)，可以使用括号。
+     * @param operands 表达式中 z1, z2, ... 对应的根节点。
+     * @return 结果的根节点。表达式有误时报错并退出。
+     */
+    int64_t evaluate(const std::string &expression,
+                     const std::vector<int64_t> &operands);
+
+    /**
+     * @brief 取出以 root 为根的ZDD。
+     * @param root 根节点。
+     * @return 按Graphillion输出的顺序排列、只包含可到达节点的ZDD。num_var 为导入的ZDD中最大的。
+     *         root 为终端时节点为空。
+     */
+    RawZdd extract(int64_t root) const;
+
+    // 存储中的节点数（包括中间结果）
+    size_t num_nodes() const { return nodes_.size(); }
+    // 运算缓存的条目数
+    size_t cache_entries() const { return cache_.size(); }
+
+   private:
+    enum Op : uint64_t { UNION, INTERSECT, SUBTRACT, ONSET, OFFSET, RESTRICT };
+
+    struct CacheEntry {
+        uint64_t key;  // f << 3 | op，空条目为 ~0
+        int64_t operand;
+        int64_t result;
+    };
+
+    // 终端的变量视为比所有变量都大
+    uint32_t top_var(int64_t f) const {
+        return f < 0 ? UINT32_MAX : nodes_[f].var;
+    }
+    size_t cache_index(uint64_t key, int64_t g) const;
+    bool cache_lookup(Op op, int64_t f, int64_t g, int64_t &result) const;
+    void cache_insert(Op op, int64_t f, int64_t g, int64_t result);
+
+    std::vector<RawNode> nodes_;
+    UniqueTable table_;
+    std::vector<CacheEntry> cache_;
+    size_t max_cache_entries_;
+    int num_var_ = 0;
+};
+
+#endif  // ZDD_ALGEBRA_H_
@@ -0,0 +1,124 @@
+// randomized check of the ZDD operations against std::set
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#include "raw_zdd.h"
+#include "test_util.h"
+#include "zdd_algebra.h"
+
+/**
+ * 随机表达式的生成和按集合运算的求值。
+ */
+class ExpressionGenerator {
+   public:
+    ExpressionGenerator(std::mt19937_64 &rng, const vector<Family> &operands,
+                        int num_var)
+        : rng_(rng), operands_(operands), num_var_(num_var) {}
+
+    /**
+     * @brief 生成一个表达式。
+     * @param depth 剩余的嵌套层数。
+     * @param value 输出表达式的值。
+     * @return ZddAlgebra::evaluate 的表达式。
+     */
+    string generate(int depth, Family &value) {
+        const int kind = depth == 0 ? 0 : rng_() % 7;
+        if (kind == 0) {
+            const size_t k = rng_() % operands_.size();
+            value = operands_[k];
+            return "z" + std::to_string(k + 1);
+        }
+        Family f;
+        const string e = generate(depth - 1, f);
+        if (kind == 4 || kind == 5) {
+            const uint32_t var = 1 + rng_() % num_var_;
+            value.clear();
+            for (const vector<uint32_t> &set : f) {
+                const bool has = binary_search(set.begin(), set.end(), var);
+                if (has == (kind == 4)) value.insert(set);
+            }
+            return string(kind == 4 ? "onset(" : "offset(") + e + ", " +
+                   std::to_string(var) + ")";
+        }
+        Family g;
+        const string h = generate(depth - 1, g);
+        value.clear();
+        switch (kind) {
+            case 1:
+                set_union(f.begin(), f.end(), g.begin(), g.end(),
+                          inserter(value, value.end()));
+                return "(" + e + " | " + h + ")";
+            case 2:
+                set_intersection(f.begin(), f.end(), g.begin(), g.end(),
+                                 inserter(value, value.end()));
+                return "(" + e + " & " + h + ")";
+            case 3:
+                set_difference(f.begin(), f.end(), g.begin(), g.end(),
+                               inserter(value, value.end()));
+                return "(" + e + " - " + h + ")";
+            default:
+                for (const vector<uint32_t> &set : f) {
+                    for (const vector<uint32_t> &sub : g) {
+                        if (includes(set.begin(), set.end(), sub.begin(),
+                                     sub.end())) {
+                            value.insert(set);
+                            break;
+                        }
+                    }
+                }
+                return "restrict(" + e + ", " + h + ")";
+        }
+    }
+
+   private:
+    std::mt19937_64 &rng_;
+    const vector<Family> &operands_;
+    const int num_var_;
+};
+
+/**
+ * 随机生成三个集合族和由并、交、差、onset、offset、restrict组成的表达式，
+ * 检查 ZddAlgebra 的结果与std::set的运算结果相同，且为约简的ZDD
+ * （节点数与由结果的集合族直接构建的ZDD相同）。奇数的种子使用最小的运算缓存，
+ * 以检查缓存条目被覆盖时的结果。
+ * usage: ./zdd_algebra_test [num_seeds]
+ */
+int main(int argc, char **argv) {
+    const int num_seeds = argc > 1 ? atoi(argv[1]) : 4000;
+    const int expressions_per_seed = 3;
+    int num_failures = 0;
+    for (int seed = 0; seed < num_seeds; seed++) {
+        std::mt19937_64 rng(seed);
+        const int num_var = 3 + rng() % 4;
+        vector<Family> families;
+        ZddAlgebra algebra(seed % 2 ? 0 : size_t(1) << 20);
+        vector<int64_t> operands;
+        for (int k = 0; k < 3; k++) {
+            families.push_back(random_family(rng, num_var, 12));
+            operands.push_back(
+                algebra.add(build_family_zdd(families.back(), num_var)));
+        }
+        ExpressionGenerator generator(rng, families, num_var);
+        for (int e = 0; e < expressions_per_seed; e++) {
+            Family expected;
+            const string expression =
+                generator.generate(1 + rng() % 4, expected);
+            RawZdd result =
+                algebra.extract(algebra.evaluate(expression, operands));
+            if (!check(enumerate_family(result) == expected,
+                       expression.c_str(), seed, num_failures)) {
+                continue;
+            }
+            check(result.nodes.size() ==
+                      build_family_zdd(expected, num_var).nodes.size(),
+                  "node count of the result", seed, num_failures);
+            check(reduce_zdd(result) == 0, "result is reduced", seed,
+                  num_failures);
+        }
+    }
+    printf("%d expressions, %d failures\n", num_seeds * expressions_per_seed,
+           num_failures);
+    return num_failures == 0 ? 0 : 1;
+}
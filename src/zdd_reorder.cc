@@ -0,0 +1,165 @@
+// offline variable reordering of ZDD files
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "raw_zdd.h"
+#include "reorder.h"
+
+using namespace std;
+
+// 显示用法并退出
+void show_help_and_exit() {
+    cerr << "usage: ./zdd_reorder [-g growth] [-n vars] zdd_file out_zdd_file "
+            "map_file\n"
+         << "       ./zdd_reorder -t map_file < solutions\n"
+         << "  -g growth: stop moving a variable in one direction when the "
+            "ZDD grows beyond growth times the best size (default 1.2)\n"
+         << "  -n vars: sift at most the given number of variables, largest "
+            "levels first (default all)\n"
+         << "  -t map_file: translate the column ids of each line read from "
+            "stdin back to the original columns\n"
+         << endl;
+    exit(1);
+}
+
+/**
+ * 读取列映射文件，每行为"新列 原列"。
+ * @param file_name 列映射文件名。
+ * @return 新列到原列的映射。
+ */
+vector<uint32_t> read_column_map(const string &file_name) {
+    ifstream ifs(file_name);
+    if (!ifs) {
+        cerr << "can't open " << file_name << endl;
+        exit(1);
+    }
+    vector<uint32_t> column_map(1, 0);
+    uint64_t column, original;
+    while (ifs >> column >> original) {
+        if (column != column_map.size()) {
+            cerr << "invalid column map " << file_name << endl;
+            exit(1);
+        }
+        column_map.push_back(original);
+    }
+    return column_map;
+}
+
+/**
+ * 把标准输入各行中的列编号换回原来的列编号，其他单词原样输出。
+ * @param column_map 新列到原列的映射。
+ */
+void translate_solutions(const vector<uint32_t> &column_map) {
+    string line, word;
+    while (getline(cin, line)) {
+        istringstream iss(line);
+        bool first = true;
+        while (iss >> word) {
+            char *end;
+            const unsigned long long column = strtoull(word.c_str(), &end, 10);
+            if (*end == '\0' && column > 0 && column < column_map.size()) {
+                word = to_string(column_map[column]);
+            }
+            cout << (first ? "" : " ") << word;
+            first = false;
+        }
+        cout << "\n";
+    }
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    double max_growth = 1.2;
+    size_t max_vars = SIZE_MAX;
+    string map_to_translate;
+    while ((opt = getopt(argc, argv, "g:n:t:h")) != -1) {
+        switch (opt) {
+            case 'g':
+                max_growth = atof(optarg);
+                break;
+            case 'n':
+                max_vars = strtoull(optarg, nullptr, 10);
+                break;
+            case 't':
+                map_to_translate = optarg;
+                break;
+            default:
+                show_help_and_exit();
+        }
+    }
+    if (!map_to_translate.empty()) {
+        translate_solutions(read_column_map(map_to_translate));
+        return 0;
+    }
+    if (argc - optind != 3 || max_growth < 1.0) show_help_and_exit();
+
+    RawZdd zdd = read_zdd_file(argv[optind]);
+    reduce_zdd(zdd);
+    const size_t initial_size = zdd.nodes.size();
+    const auto start_time = chrono::steady_clock::now();
+    ZddReorderer reorderer(zdd);
+    RawZdd().nodes.swap(zdd.nodes);
+    reorderer.sift(max_growth, max_vars);
+    vector<uint32_t> column_map;
+    const RawZdd reordered = reorderer.reordered(column_map);
+    fprintf(stderr, "nodes %zu -> %zu, %zu swaps (%lld msecs)\n",
+            initial_size, reordered.nodes.size(), reorderer.num_swaps(),
+            (long long)chrono::duration_cast<chrono::milliseconds>(
+                chrono::steady_clock::now() - start_time)
+                .count());
+
+    write_zdd_file(reordered, argv[optind + 1]);
+    FILE *fp = fopen(argv[optind + 2], "w");
+    if (!fp) {
+        cerr << "can't open " << argv[optind + 2] << endl;
+        exit(1);
+    }
+    for (size_t v = 1; v < column_map.size(); v++) {
+        fprintf(fp, "%zu %u\n", v, column_map[v]);
+    }
+    fclose(fp);
+
+    // 输入旁声明的次要列和覆盖次数的上下界换为新的列编号，写到输出旁
+    const string secondary_in = string(argv[optind]) + ".secondary";
+    if (access(secondary_in.c_str(), R_OK) == 0) {
+        const vector<uint32_t> columns = read_secondary_columns(secondary_in);
+        const string secondary_out = string(argv[optind + 1]) + ".secondary";
+        ofstream ofs(secondary_out);
+        for (size_t v = 1; v < column_map.size(); v++) {
+            if (binary_search(columns.begin(), columns.end(), column_map[v])) {
+                ofs << v << "\n";
+            }
+        }
+        if (!ofs) {
+            cerr << "can't write " << secondary_out << endl;
+            exit(1);
+        }
+    }
+    const string bounds_in = string(argv[optind]) + ".bounds";
+    if (access(bounds_in.c_str(), R_OK) == 0) {
+        const vector<ColumnBounds> bounds = read_column_bounds(bounds_in);
+        const string bounds_out = string(argv[optind + 1]) + ".bounds";
+        ofstream ofs(bounds_out);
+        for (size_t v = 1; v < column_map.size(); v++) {
+            auto it = lower_bound(
+                bounds.begin(), bounds.end(), column_map[v],
+                [](const ColumnBounds &b, uint32_t c) { return b.column < c; });
+            if (it != bounds.end() && it->column == column_map[v]) {
+                ofs << v << " " << it->lower << " " << it->upper << "\n";
+            }
+        }
+        if (!ofs) {
+            cerr << "can't write " << bounds_out << endl;
+            exit(1);
+        }
+    }
+    return 0;
+}